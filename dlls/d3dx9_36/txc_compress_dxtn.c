@@ -22,8 +22,12 @@
  * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
  */
 
+#include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include "windef.h"
+#include "winbase.h"
 #include "txc_dxtn.h"
 
 /* weights used for error function, basically weights (unsquared 2/4/1) according to rgb->luminance conversion
@@ -755,87 +759,140 @@ static void extractsrccolors( GLubyte srcpixels[4][4][4], const GLchan *srcaddr,
 }
 
 
+struct compress_params {
+   GLint srccomps;
+   GLint width;
+   GLint height;
+   const GLubyte *srcpixdata;
+   GLenum destformat;
+   GLubyte *dest;
+   GLint blocksize;
+   GLint dstblockrowpitch;
+   /* used when several threads compress the image */
+   LONG nextrow;
+   LONG activeworkers;
+   HANDLE done;
+};
+
+static void compressblockrow(const struct compress_params *params, GLint j)
+{
+   GLubyte *blkaddr = params->dest + (j / 4) * params->dstblockrowpitch;
+   const GLchan *srcaddr = params->srcpixdata + j * params->width * params->srccomps;
+   GLubyte srcpixels[4][4][4], prevpixels[4][4][4];
+   GLint numxpixels, numypixels;
+   GLint i;
+
+   memset(srcpixels, 0, sizeof(srcpixels));
+
+   if (params->height > j + 3) numypixels = 4;
+   else numypixels = params->height - j;
+   for (i = 0; i < params->width; i += 4) {
+      if (params->width > i + 3) numxpixels = 4;
+      else numxpixels = params->width - i;
+      extractsrccolors(srcpixels, srcaddr, params->width, numxpixels, numypixels, params->srccomps);
+      /* flat areas often repeat the same block, reuse the previous encoding for those */
+      if (i && numxpixels == 4 && numypixels == 4 && !memcmp(srcpixels, prevpixels, sizeof(srcpixels))) {
+         memcpy(blkaddr, blkaddr - params->blocksize, params->blocksize);
+      }
+      else {
+         switch (params->destformat) {
+         case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+         case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+            encodedxtcolorblockfaster(blkaddr, srcpixels, numxpixels, numypixels, params->destformat);
+            break;
+         case GL_COMPRESSED_RGBA_S3TC_DXT3_EXT:
+            blkaddr[0] = (srcpixels[0][0][3] >> 4) | (srcpixels[0][1][3] & 0xf0);
+            blkaddr[1] = (srcpixels[0][2][3] >> 4) | (srcpixels[0][3][3] & 0xf0);
+            blkaddr[2] = (srcpixels[1][0][3] >> 4) | (srcpixels[1][1][3] & 0xf0);
+            blkaddr[3] = (srcpixels[1][2][3] >> 4) | (srcpixels[1][3][3] & 0xf0);
+            blkaddr[4] = (srcpixels[2][0][3] >> 4) | (srcpixels[2][1][3] & 0xf0);
+            blkaddr[5] = (srcpixels[2][2][3] >> 4) | (srcpixels[2][3][3] & 0xf0);
+            blkaddr[6] = (srcpixels[3][0][3] >> 4) | (srcpixels[3][1][3] & 0xf0);
+            blkaddr[7] = (srcpixels[3][2][3] >> 4) | (srcpixels[3][3][3] & 0xf0);
+            encodedxtcolorblockfaster(blkaddr + 8, srcpixels, numxpixels, numypixels, params->destformat);
+            break;
+         case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+            encodedxt5alpha(blkaddr, srcpixels, numxpixels, numypixels);
+            encodedxtcolorblockfaster(blkaddr + 8, srcpixels, numxpixels, numypixels, params->destformat);
+            break;
+         }
+      }
+      memcpy(prevpixels, srcpixels, sizeof(srcpixels));
+      srcaddr += params->srccomps * numxpixels;
+      blkaddr += params->blocksize;
+   }
+}
+
+static void compressblockrows(struct compress_params *params)
+{
+   GLint j;
+
+   while ((j = (InterlockedIncrement(&params->nextrow) - 1) * 4) < params->height)
+      compressblockrow(params, j);
+}
+
+static void CALLBACK compressworker(TP_CALLBACK_INSTANCE *instance, void *context)
+{
+   struct compress_params *params = context;
+
+   compressblockrows(params);
+   if (!InterlockedDecrement(&params->activeworkers))
+      SetEvent(params->done);
+}
+
+/* don't bother with threads for small textures */
+#define MIN_BLOCK_ROWS_PER_THREAD 16
+
 void tx_compress_dxtn(GLint srccomps, GLint width, GLint height, const GLubyte *srcPixData,
                      GLenum destFormat, GLubyte *dest, GLint dstRowStride)
 {
-      GLubyte *blkaddr = dest;
-      GLubyte srcpixels[4][4][4];
-      const GLchan *srcaddr = srcPixData;
-      GLint numxpixels, numypixels;
-      GLint i, j;
-      GLint dstRowDiff;
+   struct compress_params params;
+   GLint dstRowDiff, blockrows, threads, i;
 
    switch (destFormat) {
    case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
    case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
       /* hmm we used to get called without dstRowStride... */
       dstRowDiff = dstRowStride >= (width * 2) ? dstRowStride - (((width + 3) & ~3) * 2) : 0;
-/*      fprintf(stderr, "dxt1 tex width %d tex height %d dstRowStride %d\n",
-              width, height, dstRowStride); */
-      for (j = 0; j < height; j += 4) {
-         if (height > j + 3) numypixels = 4;
-         else numypixels = height - j;
-         srcaddr = srcPixData + j * width * srccomps;
-         for (i = 0; i < width; i += 4) {
-            if (width > i + 3) numxpixels = 4;
-            else numxpixels = width - i;
-            extractsrccolors(srcpixels, srcaddr, width, numxpixels, numypixels, srccomps);
-            encodedxtcolorblockfaster(blkaddr, srcpixels, numxpixels, numypixels, destFormat);
-            srcaddr += srccomps * numxpixels;
-            blkaddr += 8;
-         }
-         blkaddr += dstRowDiff;
-      }
+      params.blocksize = 8;
       break;
    case GL_COMPRESSED_RGBA_S3TC_DXT3_EXT:
-      dstRowDiff = dstRowStride >= (width * 4) ? dstRowStride - (((width + 3) & ~3) * 4) : 0;
-/*      fprintf(stderr, "dxt3 tex width %d tex height %d dstRowStride %d\n",
-              width, height, dstRowStride); */
-      for (j = 0; j < height; j += 4) {
-         if (height > j + 3) numypixels = 4;
-         else numypixels = height - j;
-         srcaddr = srcPixData + j * width * srccomps;
-         for (i = 0; i < width; i += 4) {
-            if (width > i + 3) numxpixels = 4;
-            else numxpixels = width - i;
-            extractsrccolors(srcpixels, srcaddr, width, numxpixels, numypixels, srccomps);
-            *blkaddr++ = (srcpixels[0][0][3] >> 4) | (srcpixels[0][1][3] & 0xf0);
-            *blkaddr++ = (srcpixels[0][2][3] >> 4) | (srcpixels[0][3][3] & 0xf0);
-            *blkaddr++ = (srcpixels[1][0][3] >> 4) | (srcpixels[1][1][3] & 0xf0);
-            *blkaddr++ = (srcpixels[1][2][3] >> 4) | (srcpixels[1][3][3] & 0xf0);
-            *blkaddr++ = (srcpixels[2][0][3] >> 4) | (srcpixels[2][1][3] & 0xf0);
-            *blkaddr++ = (srcpixels[2][2][3] >> 4) | (srcpixels[2][3][3] & 0xf0);
-            *blkaddr++ = (srcpixels[3][0][3] >> 4) | (srcpixels[3][1][3] & 0xf0);
-            *blkaddr++ = (srcpixels[3][2][3] >> 4) | (srcpixels[3][3][3] & 0xf0);
-            encodedxtcolorblockfaster(blkaddr, srcpixels, numxpixels, numypixels, destFormat);
-            srcaddr += srccomps * numxpixels;
-            blkaddr += 8;
-         }
-         blkaddr += dstRowDiff;
-      }
-      break;
    case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
       dstRowDiff = dstRowStride >= (width * 4) ? dstRowStride - (((width + 3) & ~3) * 4) : 0;
-/*      fprintf(stderr, "dxt5 tex width %d tex height %d dstRowStride %d\n",
-              width, height, dstRowStride); */
-      for (j = 0; j < height; j += 4) {
-         if (height > j + 3) numypixels = 4;
-         else numypixels = height - j;
-         srcaddr = srcPixData + j * width * srccomps;
-         for (i = 0; i < width; i += 4) {
-            if (width > i + 3) numxpixels = 4;
-            else numxpixels = width - i;
-            extractsrccolors(srcpixels, srcaddr, width, numxpixels, numypixels, srccomps);
-            encodedxt5alpha(blkaddr, srcpixels, numxpixels, numypixels);
-            encodedxtcolorblockfaster(blkaddr + 8, srcpixels, numxpixels, numypixels, destFormat);
-            srcaddr += srccomps * numxpixels;
-            blkaddr += 16;
-         }
-         blkaddr += dstRowDiff;
-      }
+      params.blocksize = 16;
       break;
    default:
       /* fprintf(stderr, "libdxtn: Bad dstFormat %d in tx_compress_dxtn\n", destFormat); */
       return;
    }
+
+   params.srccomps = srccomps;
+   params.width = width;
+   params.height = height;
+   params.srcpixdata = srcPixData;
+   params.destformat = destFormat;
+   params.dest = dest;
+   params.dstblockrowpitch = ((width + 3) / 4) * params.blocksize + dstRowDiff;
+   params.nextrow = 0;
+   params.activeworkers = 0;
+   params.done = NULL;
+
+   /* block rows are independent of each other, so spread them over the thread pool */
+   blockrows = (height + 3) / 4;
+   threads = min(GetActiveProcessorCount(ALL_PROCESSOR_GROUPS), blockrows / MIN_BLOCK_ROWS_PER_THREAD);
+   if (threads > 1 && (params.done = CreateEventW(NULL, FALSE, FALSE, NULL))) {
+      params.activeworkers = threads - 1;
+      for (i = 0; i < threads - 1; i++) {
+         if (!TrySubmitThreadpoolCallback(compressworker, &params, NULL)
+               && !InterlockedDecrement(&params.activeworkers))
+            SetEvent(params.done);
+      }
+   }
+
+   compressblockrows(&params);
+
+   if (params.done) {
+      WaitForSingleObject(params.done, INFINITE);
+      CloseHandle(params.done);
+   }
 }
@@ -0,0 +1,212 @@
+/*
+ * DNS resolver cache
+ *
+ * Copyright 2026 agent
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include <stdarg.h>
+#include <string.h>
+#include "windef.h"
+#include "winbase.h"
+#include "winerror.h"
+#include "windns.h"
+
+#include "wine/debug.h"
+#include "wine/list.h"
+#include "dnsapi.h"
+
+WINE_DEFAULT_DEBUG_CHANNEL(dnsapi);
+
+/* Entries are kept for the smallest TTL of the answer records, capped like
+ * the MaxCacheTtl setting of the Windows DNS client. Name errors are kept for
+ * a fixed time, since the SOA record which would tell us how long is not
+ * extracted from the reply. */
+#define CACHE_MAX_ENTRIES   256
+#define CACHE_MAX_TTL       86400
+#define CACHE_NEGATIVE_TTL  60
+
+struct cache_entry
+{
+    struct list entry;
+    char *name;
+    WORD type;
+    DWORD options;
+    DNS_STATUS status;
+    DNS_RECORDA *records;
+    ULONGLONG expires;
+};
+
+/* Most recently used entries first. */
+static struct list cache = LIST_INIT( cache );
+static unsigned int cache_count;
+
+static struct
+{
+    unsigned int hits;
+    unsigned int negative_hits;
+    unsigned int misses;
+} cache_stats;
+
+static CRITICAL_SECTION cache_cs;
+static CRITICAL_SECTION_DEBUG cache_cs_debug =
+{
+    0, 0, &cache_cs,
+    { &cache_cs_debug.ProcessLocksList, &cache_cs_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": cache_cs") }
+};
+static CRITICAL_SECTION cache_cs = { &cache_cs_debug, -1, 0, 0, 0, 0 };
+
+static void free_entry( struct cache_entry *entry )
+{
+    list_remove( &entry->entry );
+    --cache_count;
+    free( entry->name );
+    DnsRecordListFree( (DNS_RECORD *)entry->records, DnsFreeRecordList );
+    free( entry );
+}
+
+static struct cache_entry *find_entry( const char *name, WORD type, DWORD options, ULONGLONG now )
+{
+    struct cache_entry *entry, *next;
+
+    LIST_FOR_EACH_ENTRY_SAFE( entry, next, &cache, struct cache_entry, entry )
+    {
+        if (entry->expires <= now)
+        {
+            free_entry( entry );
+            continue;
+        }
+        if (entry->type == type && entry->options == options && !_stricmp( entry->name, name ))
+            return entry;
+    }
+    return NULL;
+}
+
+BOOL cache_lookup( const char *name, WORD type, DWORD options, DNS_STATUS *status, DNS_RECORDA **result )
+{
+    ULONGLONG now = GetTickCount64();
+    struct cache_entry *entry;
+    DNS_RECORDA *record;
+    DWORD ttl;
+
+    EnterCriticalSection( &cache_cs );
+
+    if (!(entry = find_entry( name, type, options, now )))
+    {
+        cache_stats.misses++;
+        LeaveCriticalSection( &cache_cs );
+        return FALSE;
+    }
+
+    if ((*status = entry->status))
+        cache_stats.negative_hits++;
+    else
+    {
+        if (!(*result = (DNS_RECORDA *)DnsRecordSetCopyEx( (DNS_RECORD *)entry->records,
+                                                           DnsCharSetUtf8, DnsCharSetUtf8 )))
+        {
+            LeaveCriticalSection( &cache_cs );
+            return FALSE;
+        }
+
+        /* report the time left rather than the original TTL */
+        ttl = (entry->expires - now + 999) / 1000;
+        for (record = *result; record; record = record->pNext)
+            record->dwTtl = min( record->dwTtl, ttl );
+        cache_stats.hits++;
+    }
+
+    list_remove( &entry->entry );
+    list_add_head( &cache, &entry->entry );
+
+    LeaveCriticalSection( &cache_cs );
+
+    TRACE( "found %s type %s, status %u\n", debugstr_a(name), debugstr_type( type ), *status );
+    return TRUE;
+}
+
+void cache_insert( const char *name, WORD type, DWORD options, DNS_STATUS status, const DNS_RECORDA *records )
+{
+    ULONGLONG now = GetTickCount64();
+    struct cache_entry *entry, *old;
+    const DNS_RECORDA *record;
+    DWORD ttl = 0;
+
+    if (status == DNS_ERROR_RCODE_NAME_ERROR)
+        ttl = CACHE_NEGATIVE_TTL;
+    else if (status == ERROR_SUCCESS)
+    {
+        ttl = ~0u;
+        for (record = records; record; record = record->pNext)
+        {
+            if (record->Flags.S.Section == DnsSectionAnswer)
+                ttl = min( ttl, record->dwTtl );
+        }
+        if (ttl == ~0u) return;
+        ttl = min( ttl, CACHE_MAX_TTL );
+    }
+
+    if (!ttl) return;
+
+    if (!(entry = calloc( 1, sizeof(*entry) ))) return;
+    if (!(entry->name = strdup_u( name ))) goto error;
+    if (records && !(entry->records = (DNS_RECORDA *)DnsRecordSetCopyEx( (DNS_RECORD *)records,
+                                                                          DnsCharSetUtf8, DnsCharSetUtf8 )))
+        goto error;
+    entry->type = type;
+    entry->options = options;
+    entry->status = status;
+    entry->expires = now + ttl * 1000;
+
+    EnterCriticalSection( &cache_cs );
+
+    if ((old = find_entry( name, type, options, now )))
+        free_entry( old );
+    if (cache_count >= CACHE_MAX_ENTRIES)
+        free_entry( LIST_ENTRY( list_tail( &cache ), struct cache_entry, entry ) );
+    list_add_head( &cache, &entry->entry );
+    ++cache_count;
+
+    LeaveCriticalSection( &cache_cs );
+
+    TRACE( "added %s type %s, status %u, ttl %u\n", debugstr_a(name), debugstr_type( type ), status, ttl );
+    return;
+
+error:
+    free( entry->name );
+    free( entry );
+}
+
+BOOL cache_flush( const char *name )
+{
+    struct cache_entry *entry, *next;
+
+    EnterCriticalSection( &cache_cs );
+    LIST_FOR_EACH_ENTRY_SAFE( entry, next, &cache, struct cache_entry, entry )
+    {
+        if (!name || !_stricmp( entry->name, name ))
+            free_entry( entry );
+    }
+    LeaveCriticalSection( &cache_cs );
+    return TRUE;
+}
+
+void cache_dump_stats(void)
+{
+    TRACE( "%u hits, %u negative hits, %u misses, %u entries\n", cache_stats.hits,
+           cache_stats.negative_hits, cache_stats.misses, cache_count );
+}
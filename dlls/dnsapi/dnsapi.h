@@ -126,6 +126,11 @@ static inline char *strdup_ua( const char *src )
 
 extern const char *debugstr_type( unsigned short ) DECLSPEC_HIDDEN;
 
+extern BOOL cache_lookup( const char *, WORD, DWORD, DNS_STATUS *, DNS_RECORDA ** ) DECLSPEC_HIDDEN;
+extern void cache_insert( const char *, WORD, DWORD, DNS_STATUS, const DNS_RECORDA * ) DECLSPEC_HIDDEN;
+extern BOOL cache_flush( const char * ) DECLSPEC_HIDDEN;
+extern void cache_dump_stats(void) DECLSPEC_HIDDEN;
+
 struct get_searchlist_params
 {
     DNS_TXT_DATAW   *list;
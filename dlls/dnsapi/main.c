@@ -47,6 +47,9 @@ BOOL WINAPI DllMain( HINSTANCE hinst, DWORD reason, LPVOID reserved )
             ERR( "No libresolv support, expect problems\n" );
         break;
     case DLL_PROCESS_DETACH:
+        if (reserved) break;
+        cache_dump_stats();
+        cache_flush( NULL );
         break;
     }
     return TRUE;
@@ -97,7 +100,8 @@ DNS_STATUS WINAPI DnsAcquireContextHandle_W( DWORD flags, PVOID cred,
  */
 VOID WINAPI DnsFlushResolverCache(void)
 {
-    FIXME(": stub\n");
+    TRACE( "\n" );
+    cache_flush( NULL );
 }
 
 /******************************************************************************
@@ -106,9 +110,16 @@ VOID WINAPI DnsFlushResolverCache(void)
  */
 BOOL WINAPI DnsFlushResolverCacheEntry_A( PCSTR entry )
 {
-    FIXME( "%s: stub\n", debugstr_a(entry) );
+    char *entryU;
+    BOOL ret;
+
+    TRACE( "%s\n", debugstr_a(entry) );
     if (!entry) return FALSE;
-    return TRUE;
+
+    if (!(entryU = strdup_au( entry ))) return FALSE;
+    ret = cache_flush( entryU );
+    free( entryU );
+    return ret;
 }
 
 /******************************************************************************
@@ -117,9 +128,9 @@ BOOL WINAPI DnsFlushResolverCacheEntry_A( PCSTR entry )
  */
 BOOL WINAPI DnsFlushResolverCacheEntry_UTF8( PCSTR entry )
 {
-    FIXME( "%s: stub\n", debugstr_a(entry) );
+    TRACE( "%s\n", debugstr_a(entry) );
     if (!entry) return FALSE;
-    return TRUE;
+    return cache_flush( entry );
 }
 
 /******************************************************************************
@@ -128,9 +139,16 @@ BOOL WINAPI DnsFlushResolverCacheEntry_UTF8( PCSTR entry )
  */
 BOOL WINAPI DnsFlushResolverCacheEntry_W( PCWSTR entry )
 {
-    FIXME( "%s: stub\n", debugstr_w(entry) );
+    char *entryU;
+    BOOL ret;
+
+    TRACE( "%s\n", debugstr_w(entry) );
     if (!entry) return FALSE;
-    return TRUE;
+
+    if (!(entryU = strdup_wu( entry ))) return FALSE;
+    ret = cache_flush( entryU );
+    free( entryU );
+    return ret;
 }
 
 /******************************************************************************
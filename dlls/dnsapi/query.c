@@ -160,25 +160,14 @@ DNS_STATUS WINAPI DnsQuery_A( PCSTR name, WORD type, DWORD options, PVOID server
     return status;
 }
 
-/******************************************************************************
- * DnsQuery_UTF8              [DNSAPI.@]
- *
- */
-DNS_STATUS WINAPI DnsQuery_UTF8( PCSTR name, WORD type, DWORD options, PVOID servers,
-                                 PDNS_RECORDA *result, PVOID *reserved )
+static DNS_STATUS do_query( PCSTR name, WORD type, DWORD options, PVOID servers, PDNS_RECORDA *result )
 {
-    DNS_STATUS ret = DNS_ERROR_RCODE_NOT_IMPLEMENTED;
+    DNS_STATUS ret;
     unsigned char answer[4096];
     DWORD len = sizeof(answer);
     struct set_serverlist_params servlist_params = { servers };
     struct query_params query_params = { name, type, options, answer, &len };
 
-    TRACE( "(%s,%s,0x%08x,%p,%p,%p)\n", debugstr_a(name), debugstr_type( type ),
-           options, servers, result, reserved );
-
-    if (!name || !result)
-        return ERROR_INVALID_PARAMETER;
-
     if ((ret = RESOLV_CALL( set_serverlist, &servlist_params ))) return ret;
 
     ret = RESOLV_CALL( query, &query_params );
@@ -204,6 +193,33 @@ DNS_STATUS WINAPI DnsQuery_UTF8( PCSTR name, WORD type, DWORD options, PVOID ser
         default:                 ret = DNS_ERROR_RCODE_NOT_IMPLEMENTED; break;
         }
     }
+    return ret;
+}
+
+/******************************************************************************
+ * DnsQuery_UTF8              [DNSAPI.@]
+ *
+ */
+DNS_STATUS WINAPI DnsQuery_UTF8( PCSTR name, WORD type, DWORD options, PVOID servers,
+                                 PDNS_RECORDA *result, PVOID *reserved )
+{
+    DNS_STATUS ret;
+    BOOL use_cache;
+
+    TRACE( "(%s,%s,0x%08x,%p,%p,%p)\n", debugstr_a(name), debugstr_type( type ),
+           options, servers, result, reserved );
+
+    if (!name || !result)
+        return ERROR_INVALID_PARAMETER;
+
+    /* Queries sent to specific servers don't go through the cache. */
+    use_cache = !servers && !(options & (DNS_QUERY_BYPASS_CACHE | DNS_QUERY_WIRE_ONLY));
+
+    if (!use_cache || !cache_lookup( name, type, options, &ret, result ))
+    {
+        ret = do_query( name, type, options, servers, result );
+        if (use_cache) cache_insert( name, type, options, ret, ret ? NULL : *result );
+    }
 
     if (ret == DNS_ERROR_RCODE_NAME_ERROR && type == DNS_TYPE_A &&
         !(options & DNS_QUERY_NO_NETBT))
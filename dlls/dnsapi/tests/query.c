@@ -136,6 +136,45 @@ static IP_ADAPTER_ADDRESSES *get_adapters(void)
     return NULL;
 }
 
+static void test_DnsQuery_cache(void)
+{
+    DNS_RECORDW *rec, *rec2;
+    DNS_STATUS status;
+
+    rec = NULL;
+    status = DnsQuery_W(L"winehq.org", DNS_TYPE_A, DNS_QUERY_STANDARD, NULL, &rec, NULL);
+    if (status == ERROR_TIMEOUT)
+    {
+        skip("query timed out\n");
+        return;
+    }
+    ok(status == ERROR_SUCCESS, "got %d\n", status);
+    if (status != ERROR_SUCCESS) return;
+
+    /* A repeated query must not report a longer TTL than the first one. */
+    rec2 = NULL;
+    status = DnsQuery_W(L"WineHQ.org", DNS_TYPE_A, DNS_QUERY_STANDARD, NULL, &rec2, NULL);
+    ok(status == ERROR_SUCCESS, "got %d\n", status);
+    ok(rec2 != NULL, "expected records\n");
+    if (rec2)
+    {
+        ok(rec2->wType == DNS_TYPE_A, "got type %u\n", rec2->wType);
+        ok(rec2->dwTtl <= rec->dwTtl, "got TTL %u, expected at most %u\n", rec2->dwTtl, rec->dwTtl);
+        DnsRecordListFree(rec2, DnsFreeRecordList);
+    }
+
+    rec2 = NULL;
+    status = DnsQuery_W(L"winehq.org", DNS_TYPE_A, DNS_QUERY_BYPASS_CACHE, NULL, &rec2, NULL);
+    ok(status == ERROR_SUCCESS || status == ERROR_TIMEOUT, "got %d\n", status);
+    if (status == ERROR_SUCCESS)
+    {
+        ok(rec2->wType == DNS_TYPE_A, "got type %u\n", rec2->wType);
+        DnsRecordListFree(rec2, DnsFreeRecordList);
+    }
+
+    DnsRecordListFree(rec, DnsFreeRecordList);
+}
+
 static void test_DnsQueryConfig( void )
 {
     DWORD err, size, i, ipv6_count;
@@ -230,5 +269,6 @@ START_TEST(query)
     WSAStartup(MAKEWORD(2, 2), &data);
 
     test_DnsQuery();
+    test_DnsQuery_cache();
     test_DnsQueryConfig();
 }
@@ -324,6 +324,19 @@ void put_quad2stereo(const IDirectSoundBufferImpl *dsb, DWORD pos, DWORD channel
 void mixieee32(float *src, float *dst, unsigned samples)
 {
     TRACE("%p - %p %d\n", src, dst, samples);
+
+    /* Load a group of samples before storing any, so that the compiler can
+     * use vector instructions without checking for overlap. */
+    for (; samples >= 4; samples -= 4, src += 4, dst += 4)
+    {
+        float s0 = dst[0] + src[0], s1 = dst[1] + src[1];
+        float s2 = dst[2] + src[2], s3 = dst[3] + src[3];
+
+        dst[0] = s0;
+        dst[1] = s1;
+        dst[2] = s2;
+        dst[3] = s3;
+    }
     while (samples--)
         *(dst++) += *(src++);
 }
@@ -283,6 +283,50 @@ static inline float get_current_sample(const IDirectSoundBufferImpl *dsb,
     return dsb->get(dsb, buffer + (mixpos % buflen), channel);
 }
 
+/* Reads count consecutive samples of one channel, without a division per sample. */
+static void get_current_samples(const IDirectSoundBufferImpl *dsb, float *out,
+        BYTE *buffer, DWORD buflen, DWORD mixpos, DWORD channel, UINT count)
+{
+    UINT istride = dsb->pwfx->nBlockAlign;
+    DWORD pos;
+    UINT i;
+
+    if (!count)
+        return;
+
+    pos = mixpos % buflen;
+    for (i = 0; i < count; i++, mixpos += istride)
+    {
+        if (mixpos >= buflen && !(dsb->playflags & DSBPLAY_LOOPING))
+        {
+            memset(out + i, 0, (count - i) * sizeof(float));
+            break;
+        }
+        out[i] = dsb->get(dsb, buffer + pos, channel);
+        if ((pos += istride) >= buflen)
+            pos %= buflen;
+    }
+}
+
+/* Four independent sums, so that the compiler can vectorize the loop. */
+static inline float fir_dot_product(const float *fir_copy, const float *samples, int len)
+{
+    float sum0 = 0.0f, sum1 = 0.0f, sum2 = 0.0f, sum3 = 0.0f;
+    int j;
+
+    for (j = 0; j + 4 <= len; j += 4)
+    {
+        sum0 += fir_copy[j] * samples[j];
+        sum1 += fir_copy[j + 1] * samples[j + 1];
+        sum2 += fir_copy[j + 2] * samples[j + 2];
+        sum3 += fir_copy[j + 3] * samples[j + 3];
+    }
+    for (; j < len; j++)
+        sum0 += fir_copy[j] * samples[j];
+
+    return (sum0 + sum1) + (sum2 + sum3);
+}
+
 static UINT cp_fields_noresample(IDirectSoundBufferImpl *dsb, UINT count)
 {
     UINT istride = dsb->pwfx->nBlockAlign;
@@ -323,7 +367,9 @@ static UINT cp_fields_resample(IDirectSoundBufferImpl *dsb, UINT count, LONG64 *
 
     UINT fir_cachesize = (fir_len + dsbfirstep - 2) / dsbfirstep;
     UINT required_input = max_ipos + fir_cachesize;
+    UINT ochannels = dsb->device->pwfx->nChannels;
     float *intermediate, *fir_copy, *itmp;
+    float *obuf = dsb->put == putieee32 ? dsb->device->tmp_buffer : NULL;
 
     DWORD len = required_input * channels;
     len += fir_cachesize;
@@ -351,12 +397,11 @@ static UINT cp_fields_resample(IDirectSoundBufferImpl *dsb, UINT count, LONG64 *
      */
     itmp = intermediate;
     for (channel = 0; channel < channels; channel++) {
-        for (i = 0; i < committed_samples; i++)
-            *(itmp++) = get_current_sample(dsb, dsb->committedbuff,
-                dsb->writelead, dsb->committed_mixpos + i * istride, channel);
-        for (; i < required_input; i++)
-            *(itmp++) = get_current_sample(dsb, dsb->buffer->memory,
-                    dsb->buflen, dsb->sec_mixpos + i * istride, channel);
+        get_current_samples(dsb, itmp, dsb->committedbuff, dsb->writelead,
+                dsb->committed_mixpos, channel, committed_samples);
+        get_current_samples(dsb, itmp + committed_samples, dsb->buffer->memory, dsb->buflen,
+                dsb->sec_mixpos + committed_samples * istride, channel, required_input - committed_samples);
+        itmp += required_input;
     }
 
     for(i = 0; i < count; ++i) {
@@ -366,23 +411,24 @@ static UINT cp_fields_resample(IDirectSoundBufferImpl *dsb, UINT count, LONG64 *
 
         UINT idx = (ipos + 1) * dsbfirstep - int_fir_steps - 1;
         float rem = int_fir_steps + 1.0 - total_fir_steps;
+        float rem_inv = 1.0f - rem;
 
         int fir_used = 0;
         while (idx < fir_len - 1) {
-            fir_copy[fir_used++] = fir[idx] * (1.0 - rem) + fir[idx + 1] * rem;
-            idx += dsb->firstep;
+            fir_copy[fir_used++] = fir[idx] * rem_inv + fir[idx + 1] * rem;
+            idx += dsbfirstep;
         }
 
         assert(fir_used <= fir_cachesize);
         assert(ipos + fir_used <= required_input);
 
-        for (channel = 0; channel < dsb->mix_channels; channel++) {
-            int j;
-            float sum = 0.0;
-            float* cache = &intermediate[channel * required_input + ipos];
-            for (j = 0; j < fir_used; j++)
-                sum += fir_copy[j] * cache[j];
-            dsb->put(dsb, i * ostride, channel, sum * dsb->firgain);
+        for (channel = 0; channel < channels; channel++) {
+            float sum = fir_dot_product(fir_copy, &intermediate[channel * required_input + ipos], fir_used);
+
+            if (obuf)
+                obuf[i * ochannels + channel] = sum * dsb->firgain;
+            else
+                dsb->put(dsb, i * ostride, channel, sum * dsb->firgain);
         }
     }
 
@@ -479,11 +525,14 @@ static void DSOUND_MixToTemporary(IDirectSoundBufferImpl *dsb, DWORD frames)
 	}
 }
 
-static void DSOUND_MixerVol(const IDirectSoundBufferImpl *dsb, INT frames)
+/* Applies the buffer volume while adding the temporary buffer into the mix
+ * buffer, so that the samples are only walked once. */
+static void DSOUND_MixerVol(const IDirectSoundBufferImpl *dsb, float *mix_buffer, INT frames)
 {
 	INT	i;
 	float vols[DS_MAX_CHANNELS];
 	UINT channels = dsb->device->pwfx->nChannels, chan;
+	const float *buf = dsb->device->tmp_buffer;
 
 	TRACE("(%p,%d)\n",dsb,frames);
 	TRACE("left = %x, right = %x\n", dsb->volpan.dwTotalAmpFactor[0],
@@ -492,20 +541,37 @@ static void DSOUND_MixerVol(const IDirectSoundBufferImpl *dsb, INT frames)
 	if ((!(dsb->dsbd.dwFlags & DSBCAPS_CTRLPAN) || (dsb->volpan.lPan == 0)) &&
 	    (!(dsb->dsbd.dwFlags & DSBCAPS_CTRLVOLUME) || (dsb->volpan.lVolume == 0)) &&
 	     !(dsb->dsbd.dwFlags & DSBCAPS_CTRL3D))
-		return; /* Nothing to do */
+	{
+		mixieee32(dsb->device->tmp_buffer, mix_buffer, frames * channels);
+		return;
+	}
 
 	if (channels > DS_MAX_CHANNELS)
 	{
 		FIXME("There is no support for %u channels\n", channels);
+		mixieee32(dsb->device->tmp_buffer, mix_buffer, frames * channels);
 		return;
 	}
 
 	for (i = 0; i < channels; ++i)
 		vols[i] = dsb->volpan.dwTotalAmpFactor[i] / ((float)0xFFFF);
 
+	if (channels == 2)
+	{
+		for (i = 0; i < frames; ++i)
+		{
+			float left = buf[2 * i] * vols[0];
+			float right = buf[2 * i + 1] * vols[1];
+
+			mix_buffer[2 * i] += left;
+			mix_buffer[2 * i + 1] += right;
+		}
+		return;
+	}
+
 	for(i = 0; i < frames; ++i){
 		for(chan = 0; chan < channels; ++chan){
-			dsb->device->tmp_buffer[i * channels + chan] *= vols[chan];
+			mix_buffer[i * channels + chan] += buf[i * channels + chan] * vols[chan];
 		}
 	}
 }
@@ -524,7 +590,6 @@ static void DSOUND_MixerVol(const IDirectSoundBufferImpl *dsb, INT frames)
  */
 static DWORD DSOUND_MixInBuffer(IDirectSoundBufferImpl *dsb, float *mix_buffer, DWORD frames)
 {
-	float *ibuf;
 	DWORD oldpos;
 
 	TRACE("sec_mixpos=%d/%d\n", dsb->sec_mixpos, dsb->buflen);
@@ -533,12 +598,9 @@ static DWORD DSOUND_MixInBuffer(IDirectSoundBufferImpl *dsb, float *mix_buffer,
 	/* Resample buffer to temporary buffer specifically allocated for this purpose, if needed */
 	oldpos = dsb->sec_mixpos;
 	DSOUND_MixToTemporary(dsb, frames);
-	ibuf = dsb->device->tmp_buffer;
-
-	/* Apply volume if needed */
-	DSOUND_MixerVol(dsb, frames);
 
-	mixieee32(ibuf, mix_buffer, frames * dsb->device->pwfx->nChannels);
+	/* Add it to the mix buffer, applying volume if needed */
+	DSOUND_MixerVol(dsb, mix_buffer, frames);
 
 	/* check for notification positions */
 	if (dsb->dsbd.dwFlags & DSBCAPS_CTRLPOSITIONNOTIFY &&
@@ -559,6 +559,59 @@ static void test_CreatePolyPolygonRgn(void)
     DeleteObject(region);
 }
 
+static void test_CombineRgn_dest(void)
+{
+    HRGN grid, dest, tmp;
+    RECT rect;
+    int ret, x, y;
+
+    /* build a checkerboard so that the region has many bands */
+    grid = CreateRectRgn( 0, 0, 0, 0 );
+    tmp = CreateRectRgn( 0, 0, 0, 0 );
+    for (y = 0; y < 16; y++)
+        for (x = y % 2; x < 16; x += 2)
+        {
+            SetRectRgn( tmp, x * 10, y * 10, x * 10 + 10, y * 10 + 10 );
+            ret = CombineRgn( grid, grid, tmp, RGN_OR );
+            ok( ret == SIMPLEREGION || ret == COMPLEXREGION, "CombineRgn failed: %d\n", ret );
+        }
+
+    /* the previous contents of the destination must be replaced */
+    dest = CreateRectRgn( 500, 500, 600, 600 );
+    SetRectRgn( tmp, 0, 0, 80, 160 );
+    ret = CombineRgn( dest, grid, tmp, RGN_AND );
+    ok( ret == COMPLEXREGION, "CombineRgn returned %d\n", ret );
+    ret = GetRgnBox( dest, &rect );
+    ok( ret == COMPLEXREGION, "GetRgnBox returned %d\n", ret );
+    ok( rect.left == 0 && rect.top == 0 && rect.right == 80 && rect.bottom == 160,
+        "wrong box %s\n", wine_dbgstr_rect( &rect ) );
+    ok( !PtInRegion( dest, 550, 550 ), "old contents still present\n" );
+
+    for (y = 0; y < 16; y++)
+        for (x = 0; x < 8; x++)
+        {
+            BOOL expect = (x + y) % 2 == 0;
+            ok( PtInRegion( dest, x * 10 + 5, y * 10 + 5 ) == expect,
+                "%d,%d: wrong PtInRegion result\n", x, y );
+            SetRect( &rect, x * 10 + 2, y * 10 + 2, x * 10 + 8, y * 10 + 8 );
+            ok( RectInRegion( dest, &rect ) == expect, "%d,%d: wrong RectInRegion result\n", x, y );
+        }
+    ok( !PtInRegion( dest, 85, 5 ), "point outside of the clip rect\n" );
+
+    /* the destination can also be reused with a smaller result */
+    SetRectRgn( tmp, 10, 10, 20, 20 );
+    ret = CombineRgn( dest, grid, tmp, RGN_AND );
+    ok( ret == SIMPLEREGION, "CombineRgn returned %d\n", ret );
+    ret = CombineRgn( dest, grid, dest, RGN_DIFF );
+    ok( ret == COMPLEXREGION, "CombineRgn returned %d\n", ret );
+    ok( !PtInRegion( dest, 15, 15 ), "point should have been removed\n" );
+    ok( PtInRegion( dest, 5, 5 ), "point should be in region\n" );
+
+    DeleteObject( tmp );
+    DeleteObject( dest );
+    DeleteObject( grid );
+}
+
 START_TEST(clipping)
 {
     test_GetRandomRgn();
@@ -567,4 +620,5 @@ START_TEST(clipping)
     test_memory_dc_clipping();
     test_window_dc_clipping();
     test_CreatePolyPolygonRgn();
+    test_CombineRgn_dest();
 }
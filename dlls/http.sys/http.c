@@ -93,35 +93,36 @@ struct request_queue
 
 static struct list request_queues = LIST_INIT(request_queues);
 
-static void accept_connection(SOCKET socket)
+/* Accept all pending connections on a listening socket. */
+static void accept_connections(SOCKET socket)
 {
     struct connection *conn;
     ULONG true = 1;
     SOCKET peer;
 
-    if ((peer = accept(socket, NULL, NULL)) == INVALID_SOCKET)
-        return;
-
-    if (!(conn = heap_alloc_zero(sizeof(*conn))))
-    {
-        ERR("Failed to allocate memory.\n");
-        shutdown(peer, SD_BOTH);
-        closesocket(peer);
-        return;
-    }
-    if (!(conn->buffer = heap_alloc(8192)))
+    while ((peer = accept(socket, NULL, NULL)) != INVALID_SOCKET)
     {
-        ERR("Failed to allocate buffer memory.\n");
-        heap_free(conn);
-        shutdown(peer, SD_BOTH);
-        closesocket(peer);
-        return;
+        if (!(conn = heap_alloc_zero(sizeof(*conn))))
+        {
+            ERR("Failed to allocate memory.\n");
+            shutdown(peer, SD_BOTH);
+            closesocket(peer);
+            continue;
+        }
+        if (!(conn->buffer = heap_alloc(8192)))
+        {
+            ERR("Failed to allocate buffer memory.\n");
+            heap_free(conn);
+            shutdown(peer, SD_BOTH);
+            closesocket(peer);
+            continue;
+        }
+        conn->size = 8192;
+        WSAEventSelect(peer, request_event, FD_READ | FD_CLOSE);
+        ioctlsocket(peer, FIONBIO, &true);
+        conn->socket = peer;
+        list_add_head(&connections, &conn->entry);
     }
-    conn->size = 8192;
-    WSAEventSelect(peer, request_event, FD_READ | FD_CLOSE);
-    ioctlsocket(peer, FIONBIO, &true);
-    conn->socket = peer;
-    list_add_head(&connections, &conn->entry);
 }
 
 static void close_connection(struct connection *conn)
@@ -540,10 +541,58 @@ static void receive_data(struct connection *conn)
     }
 }
 
+static WSAPOLLFD *poll_fds;
+static unsigned int poll_fds_size;
+
+/* Find out which connections have something for us to do, so that we only
+ * have to call recv() on those rather than on every open connection. Returns
+ * the number of connections polled, or -1 if they should all be checked. */
+static int poll_connections(void)
+{
+    struct connection *conn;
+    unsigned int count = 0;
+
+    LIST_FOR_EACH_ENTRY(conn, &connections, struct connection, entry)
+        ++count;
+
+    if (count > poll_fds_size)
+    {
+        unsigned int new_size = max(count, max(poll_fds_size * 2, 16));
+        WSAPOLLFD *new_fds;
+
+        if (!(new_fds = heap_realloc(poll_fds, new_size * sizeof(*new_fds))))
+        {
+            ERR("Failed to allocate memory.\n");
+            return -1;
+        }
+        poll_fds = new_fds;
+        poll_fds_size = new_size;
+    }
+
+    count = 0;
+    LIST_FOR_EACH_ENTRY(conn, &connections, struct connection, entry)
+    {
+        poll_fds[count].fd = conn->socket;
+        /* Connections waiting for an IRP or for a response are only
+         * interested in the socket closing, which is always reported. */
+        poll_fds[count].events = (!conn->available && !conn->req_id) ? POLLRDNORM : 0;
+        poll_fds[count].revents = 0;
+        ++count;
+    }
+
+    if (count && WSAPoll(poll_fds, count, 0) < 0)
+    {
+        ERR("Failed to poll connections, error %u.\n", WSAGetLastError());
+        return -1;
+    }
+    return count;
+}
+
 static DWORD WINAPI request_thread_proc(void *arg)
 {
     struct connection *conn, *cursor;
     struct request_queue *queue;
+    int count, i;
 
     TRACE("Starting request thread.\n");
 
@@ -554,12 +603,16 @@ static DWORD WINAPI request_thread_proc(void *arg)
         LIST_FOR_EACH_ENTRY(queue, &request_queues, struct request_queue, entry)
         {
             if (queue->socket != -1)
-                accept_connection(queue->socket);
+                accept_connections(queue->socket);
         }
 
+        count = poll_connections();
+        i = 0;
         LIST_FOR_EACH_ENTRY_SAFE(conn, cursor, &connections, struct connection, entry)
         {
-            receive_data(conn);
+            if (count < 0 || (i < count && poll_fds[i].revents))
+                receive_data(conn);
+            ++i;
         }
 
         LeaveCriticalSection(&http_cs);
@@ -710,6 +763,19 @@ static struct connection *get_connection(HTTP_REQUEST_ID req_id)
     return NULL;
 }
 
+/* Find a request which was received before any IRP was available for it. */
+static struct connection *get_pending_connection(struct request_queue *queue)
+{
+    struct connection *conn;
+
+    LIST_FOR_EACH_ENTRY(conn, &connections, struct connection, entry)
+    {
+        if (conn->available && conn->queue == queue && conn->req_id == HTTP_NULL_ID)
+            return conn;
+    }
+    return NULL;
+}
+
 static void WINAPI http_receive_request_cancel(DEVICE_OBJECT *device, IRP *irp)
 {
     TRACE("device %p, irp %p.\n", device, irp);
@@ -735,7 +801,12 @@ static NTSTATUS http_receive_request(struct request_queue *queue, IRP *irp)
 
     EnterCriticalSection(&http_cs);
 
-    if ((conn = get_connection(params->id)) && conn->available && conn->queue == queue)
+    if (params->id == HTTP_NULL_ID)
+        conn = get_pending_connection(queue);
+    else
+        conn = get_connection(params->id);
+
+    if (conn && conn->available && conn->queue == queue)
     {
         ret = complete_irp(conn, irp);
         LeaveCriticalSection(&http_cs);
@@ -958,6 +1029,7 @@ static void WINAPI unload(DRIVER_OBJECT *driver)
     WaitForSingleObject(request_thread, INFINITE);
     CloseHandle(request_thread);
     CloseHandle(request_event);
+    heap_free(poll_fds);
 
     LIST_FOR_EACH_ENTRY_SAFE(conn, conn_next, &connections, struct connection, entry)
     {
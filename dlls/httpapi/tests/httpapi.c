@@ -452,7 +452,7 @@ static void test_v1_multiple_requests(void)
     unsigned short port;
     char req_text[200];
     DWORD ret_size;
-    SOCKET s1, s2;
+    SOCKET s1, s2, s3;
     HANDLE queue;
     ULONG ret;
     int len;
@@ -538,10 +538,35 @@ static void test_v1_multiple_requests(void)
     ok(req1->RequestId != req2->RequestId,
             "Expected different request IDs, but got %s.\n", wine_dbgstr_longlong(req1->RequestId));
 
+    ret = HttpSendHttpResponse(queue, req2->RequestId, 0, (HTTP_RESPONSE *)&response, NULL, NULL, NULL, 0, &ovl2, NULL);
+    ok(!ret, "Got error %u.\n", ret);
+
+    /* Test receiving a request which arrived before any IRP was queued, while
+     * other connections are idle. */
+
+    ret = send(s2, req_text, strlen(req_text), 0);
+    ok(ret == strlen(req_text), "send() returned %d.\n", ret);
+    Sleep(100);
+    s3 = create_client_socket(port);
+    Sleep(100);
+
+    memset(req_buffer1, 0xcc, sizeof(req_buffer1));
+    ret = HttpReceiveHttpRequest(queue, HTTP_NULL_ID, 0, (HTTP_REQUEST *)req1, sizeof(req_buffer1), NULL, &ovl1);
+    ok(!ret || ret == ERROR_IO_PENDING, "Got error %u.\n", ret);
+    ret = WaitForSingleObject(ovl1.hEvent, 100);
+    ok(!ret, "Got %u.\n", ret);
+
+    len = sizeof(sockaddr);
+    getsockname(s2, (struct sockaddr *)&sockaddr, &len);
+    ok(!memcmp(req1->Address.pRemoteAddress, &sockaddr, len), "Client addresses didn't match.\n");
+
+    send_response_v1(queue, req1->RequestId, s2);
+
     ret = remove_url_v1(queue, port);
     ok(!ret, "Got error %u.\n", ret);
     closesocket(s1);
     closesocket(s2);
+    closesocket(s3);
     CloseHandle(ovl1.hEvent);
     CloseHandle(ovl2.hEvent);
     ret = CloseHandle(queue);
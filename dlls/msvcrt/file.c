@@ -2832,7 +2832,8 @@ static int read_i(int fd, ioinfo *fdinfo, void *buf, unsigned int count)
         }
         else if (fdinfo->wxflag & WX_TEXT)
         {
-            DWORD i, j;
+            DWORD i, j, next_cr = 0, next_eof = 0;
+            BOOL scanned = FALSE;
 
             if (bufstart[0]=='\n' && (!utf16 || bufstart[1]==0))
                 fdinfo->wxflag |= WX_READNL;
@@ -2841,6 +2842,28 @@ static int read_i(int fd, ioinfo *fdinfo, void *buf, unsigned int count)
 
             for (i=0, j=0; i<num_read; i+=1+utf16)
             {
+                if (!utf16)
+                {
+                    /* Move runs of bytes that need no translation at once. */
+                    const char *p;
+                    DWORD end;
+
+                    if (!scanned || next_cr < i)
+                        next_cr = (p = memchr(bufstart + i, '\r', num_read - i)) ? p - bufstart : num_read;
+                    if (!scanned || next_eof < i)
+                        next_eof = (p = memchr(bufstart + i, 0x1a, num_read - i)) ? p - bufstart : num_read;
+                    scanned = TRUE;
+
+                    end = min(next_cr, next_eof);
+                    if (end > i)
+                    {
+                        if (j != i) memmove(bufstart + j, bufstart + i, end - i);
+                        j += end - i;
+                        i = end;
+                        if (i == num_read) break;
+                    }
+                }
+
                 /* in text mode, a ctrl-z signals EOF */
                 if (bufstart[i]==0x1a && (!utf16 || bufstart[i+1]==0))
                 {
@@ -3470,10 +3493,12 @@ int CDECL _write(int fd, const void* buf, unsigned int count)
     if (_isatty(fd)) console = VerifyConsoleIoHandle(hand);
     for (i = 0; i < count;)
     {
-        const char *s = buf;
+        const char *s = buf, *data;
         char lfbuf[2048];
         DWORD j = 0;
 
+        data = lfbuf;
+
         if (!(info->exflag & (EF_UTF8|EF_UTF16)) && console)
         {
             char conv[sizeof(lfbuf)];
@@ -3528,11 +3553,33 @@ int CDECL _write(int fd, const void* buf, unsigned int count)
         }
         else if (!(info->exflag & (EF_UTF8|EF_UTF16)))
         {
-            for (j = 0; i < count && j < sizeof(lfbuf)-1; i++, j++)
+            const char *nl = memchr(s + i, '\n', min(count - i, sizeof(lfbuf)));
+
+            if (!nl && count - i >= sizeof(lfbuf))
             {
-                if (s[i] == '\n')
-                    lfbuf[j++] = '\r';
-                lfbuf[j] = s[i];
+                /* Write long runs without newlines directly from the caller's buffer. */
+                nl = memchr(s + i, '\n', count - i);
+                data = s + i;
+                j = (nl ? nl - s : count) - i;
+                i += j;
+            }
+            else
+            {
+                for (j = 0; i < count && j < sizeof(lfbuf)-1;)
+                {
+                    DWORD len = min(count - i, sizeof(lfbuf) - 1 - j);
+
+                    if ((nl = memchr(s + i, '\n', len))) len = nl - (s + i);
+                    memcpy(lfbuf + j, s + i, len);
+                    i += len;
+                    j += len;
+                    if (nl)
+                    {
+                        lfbuf[j++] = '\r';
+                        lfbuf[j++] = '\n';
+                        i++;
+                    }
+                }
             }
         }
         else if (info->exflag & EF_UTF16 || console)
@@ -3578,7 +3625,7 @@ int CDECL _write(int fd, const void* buf, unsigned int count)
             if (!WriteConsoleW(hand, lfbuf, j, &num_written, NULL))
                 num_written = -1;
         }
-        else if (!WriteFile(hand, lfbuf, j, &num_written, NULL))
+        else if (!WriteFile(hand, data, j, &num_written, NULL))
         {
             num_written = -1;
         }
@@ -53,8 +53,199 @@ static unsigned int MSVCRT_amblksiz = 16;
 /* FIXME - According to documentation it should be 480 bytes, at runtime default is 0 */
 static size_t MSVCRT_sbh_threshold = 0;
 
+/* Optional per-thread cache for small blocks, enabled by setting
+ * WINE_MSVCRT_THREAD_CACHE=1. Blocks are carved out of slabs allocated from
+ * the CRT heap; each block is preceded by a header pointing back to its slab
+ * and holding the requested size, so that _msize and realloc keep their
+ * semantics. Blocks freed by another thread are handed back to the owning
+ * cache through a lock-free list, and caches of exited threads are reused
+ * by new threads. */
+#define TCACHE_SLAB_SIZE    0x10000
+#define TCACHE_GRANULARITY  16
+#define TCACHE_CLASSES      32
+#define TCACHE_MAX_SIZE     (TCACHE_CLASSES * TCACHE_GRANULARITY)
+#define TCACHE_HASH_BITS    13
+#define TCACHE_HASH_SIZE    (1 << TCACHE_HASH_BITS)
+#define TCACHE_MAX_SLABS    (TCACHE_HASH_SIZE / 2)
+
+struct tcache
+{
+    struct tcache *next_orphan;
+    void * volatile remote;                     /* blocks freed by other threads */
+    struct tcache_slab *slab[TCACHE_CLASSES];   /* slabs being carved */
+    void *free[TCACHE_CLASSES];                 /* free lists, linked through the block data */
+};
+
+struct tcache_slab
+{
+    struct tcache *owner;
+    unsigned int class;
+    unsigned int next;                          /* offset of the first uncarved byte */
+};
+
+#define TCACHE_SLAB_HEADER ((sizeof(struct tcache_slab) + 15) & ~15)
+
+struct tcache_block
+{
+    struct tcache_slab *slab;
+    size_t size;
+};
+
+static DWORD tcache_tls = TLS_OUT_OF_INDEXES;
+static struct tcache *tcache_orphans;
+static struct tcache_slab *tcache_slabs[TCACHE_HASH_SIZE];
+static LONG tcache_slab_count;
+
+static unsigned int tcache_hash(const struct tcache_slab *slab)
+{
+    return (unsigned int)((ULONG_PTR)slab >> 4) * 2654435761u >> (32 - TCACHE_HASH_BITS);
+}
+
+static struct tcache *tcache_get(BOOL create)
+{
+    DWORD err = GetLastError();  /* need to preserve last error */
+    struct tcache *cache;
+
+    if (!(cache = TlsGetValue(tcache_tls)) && create)
+    {
+        LOCK_HEAP;
+        if ((cache = tcache_orphans))
+            tcache_orphans = cache->next_orphan;
+        UNLOCK_HEAP;
+
+        if (cache || (cache = HeapAlloc(heap, HEAP_ZERO_MEMORY, sizeof(*cache))))
+            TlsSetValue(tcache_tls, cache);
+    }
+    SetLastError(err);
+    return cache;
+}
+
+static struct tcache_slab *tcache_new_slab(struct tcache *cache, unsigned int class)
+{
+    struct tcache_slab *slab;
+    unsigned int i;
+
+    if (InterlockedIncrement(&tcache_slab_count) > TCACHE_MAX_SLABS
+            || !(slab = HeapAlloc(heap, 0, TCACHE_SLAB_SIZE)))
+    {
+        InterlockedDecrement(&tcache_slab_count);
+        return NULL;
+    }
+    slab->owner = cache;
+    slab->class = class;
+    slab->next = TCACHE_SLAB_HEADER;
+
+    for (i = tcache_hash(slab); ; i = (i + 1) % TCACHE_HASH_SIZE)
+        if (!InterlockedCompareExchangePointer((void **)&tcache_slabs[i], slab, NULL)) break;
+    return slab;
+}
+
+/* Returns the block header if ptr was allocated from a thread cache. */
+static struct tcache_block *tcache_get_block(void *ptr)
+{
+    struct tcache_block *block = (struct tcache_block *)ptr - 1;
+    struct tcache_slab *slab;
+    unsigned int i;
+
+    if (!ptr || !tcache_slab_count) return NULL;
+
+    slab = block->slab;
+    for (i = tcache_hash(slab); tcache_slabs[i]; i = (i + 1) % TCACHE_HASH_SIZE)
+    {
+        if (tcache_slabs[i] != slab) continue;
+        if ((char *)ptr > (char *)slab && (char *)ptr < (char *)slab + TCACHE_SLAB_SIZE)
+            return block;
+        break;
+    }
+    return NULL;
+}
+
+static void tcache_drain_remote(struct tcache *cache)
+{
+    void *ptr = InterlockedExchangePointer((void **)&cache->remote, NULL), *next;
+
+    while (ptr)
+    {
+        struct tcache_block *block = (struct tcache_block *)ptr - 1;
+
+        next = *(void **)ptr;
+        *(void **)ptr = cache->free[block->slab->class];
+        cache->free[block->slab->class] = ptr;
+        ptr = next;
+    }
+}
+
+static void *tcache_alloc(size_t size)
+{
+    unsigned int class = size ? (size - 1) / TCACHE_GRANULARITY : 0;
+    struct tcache_block *block;
+    struct tcache_slab *slab;
+    struct tcache *cache;
+    size_t stride;
+    void *ptr;
+
+    if (!(cache = tcache_get(TRUE))) return NULL;
+
+    if (!cache->free[class] && cache->remote)
+        tcache_drain_remote(cache);
+
+    if ((ptr = cache->free[class]))
+    {
+        cache->free[class] = *(void **)ptr;
+        block = (struct tcache_block *)ptr - 1;
+    }
+    else
+    {
+        stride = sizeof(struct tcache_block) + (class + 1) * TCACHE_GRANULARITY;
+        slab = cache->slab[class];
+        if (!slab || slab->next + stride > TCACHE_SLAB_SIZE)
+        {
+            if (!(slab = tcache_new_slab(cache, class))) return NULL;
+            cache->slab[class] = slab;
+        }
+        block = (struct tcache_block *)((char *)slab + slab->next);
+        block->slab = slab;
+        slab->next += stride;
+    }
+
+    block->size = size;
+    return block + 1;
+}
+
+static void tcache_free(struct tcache_block *block)
+{
+    struct tcache *owner = block->slab->owner;
+    unsigned int class = block->slab->class;
+    void *ptr = block + 1, *next;
+
+    if (tcache_get(FALSE) == owner)
+    {
+        *(void **)ptr = owner->free[class];
+        owner->free[class] = ptr;
+        return;
+    }
+
+    do
+    {
+        next = owner->remote;
+        *(void **)ptr = next;
+    } while (InterlockedCompareExchangePointer((void **)&owner->remote, ptr, next) != next);
+}
+
 static void* msvcrt_heap_alloc(DWORD flags, size_t size)
 {
+    if(size <= TCACHE_MAX_SIZE && tcache_tls != TLS_OUT_OF_INDEXES)
+    {
+        void *ret = tcache_alloc(size);
+
+        if(ret)
+        {
+            if(flags & HEAP_ZERO_MEMORY)
+                memset(ret, 0, size);
+            return ret;
+        }
+    }
+
     if(size < MSVCRT_sbh_threshold)
     {
         void *memblock, *temp, **saved;
@@ -73,6 +264,27 @@ static void* msvcrt_heap_alloc(DWORD flags, size_t size)
 
 static void* msvcrt_heap_realloc(DWORD flags, void *ptr, size_t size)
 {
+    struct tcache_block *block;
+
+    if((block = tcache_get_block(ptr)))
+    {
+        void *ret;
+
+        if(size <= (block->slab->class + 1) * TCACHE_GRANULARITY)
+        {
+            block->size = size;
+            return ptr;
+        }
+        if(flags & HEAP_REALLOC_IN_PLACE_ONLY)
+            return NULL;
+
+        if(!(ret = msvcrt_heap_alloc(flags, size)))
+            return NULL;
+        memcpy(ret, ptr, block->size);
+        tcache_free(block);
+        return ret;
+    }
+
     if(sb_heap && ptr && !HeapValidate(heap, 0, ptr))
     {
         /* TODO: move data to normal heap if it exceeds sbh_threshold limit */
@@ -105,6 +317,14 @@ static void* msvcrt_heap_realloc(DWORD flags, void *ptr, size_t size)
 
 static BOOL msvcrt_heap_free(void *ptr)
 {
+    struct tcache_block *block;
+
+    if((block = tcache_get_block(ptr)))
+    {
+        tcache_free(block);
+        return TRUE;
+    }
+
     if(sb_heap && ptr && !HeapValidate(heap, 0, ptr))
     {
         void **saved = SAVED_PTR(ptr);
@@ -116,6 +336,11 @@ static BOOL msvcrt_heap_free(void *ptr)
 
 static size_t msvcrt_heap_size(void *ptr)
 {
+    struct tcache_block *block;
+
+    if((block = tcache_get_block(ptr)))
+        return block->size;
+
     if(sb_heap && ptr && !HeapValidate(heap, 0, ptr))
     {
         void **saved = SAVED_PTR(ptr);
@@ -867,12 +1092,39 @@ int CDECL strncpy_s(char *dest, size_t numberOfElements,
 
 BOOL msvcrt_init_heap(void)
 {
+    WCHAR buf[2];
+
     heap = HeapCreate(0, 0, 0);
-    return heap != NULL;
+    if(!heap)
+        return FALSE;
+
+    if(GetEnvironmentVariableW(L"WINE_MSVCRT_THREAD_CACHE", buf, ARRAY_SIZE(buf)) == 1 && buf[0] == '1')
+    {
+        TRACE("using per-thread small block cache\n");
+        tcache_tls = TlsAlloc();
+    }
+    return TRUE;
+}
+
+void msvcrt_free_heap_thread_cache(void)
+{
+    struct tcache *cache;
+
+    if(tcache_tls == TLS_OUT_OF_INDEXES || !(cache = TlsGetValue(tcache_tls)))
+        return;
+
+    /* Blocks owned by the cache may still be in use, keep it for another thread. */
+    TlsSetValue(tcache_tls, NULL);
+    LOCK_HEAP;
+    cache->next_orphan = tcache_orphans;
+    tcache_orphans = cache;
+    UNLOCK_HEAP;
 }
 
 void msvcrt_destroy_heap(void)
 {
+    if(tcache_tls != TLS_OUT_OF_INDEXES)
+        TlsFree(tcache_tls);
     HeapDestroy(heap);
     if(sb_heap)
         HeapDestroy(sb_heap);
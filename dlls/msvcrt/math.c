@@ -65,11 +65,44 @@ typedef int (CDECL *MSVCRT_matherr_func)(struct _exception *);
 static MSVCRT_matherr_func MSVCRT_default_matherr_func = NULL;
 
 BOOL sse2_supported;
+BOOL erms_supported;
 static BOOL sse2_enabled;
 
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__i386__) || defined(__x86_64__))
+static void do_cpuid( unsigned int ax, unsigned int cx, unsigned int *p )
+{
+#ifdef __i386__
+    __asm__ __volatile__( "pushl %%ebx\n\t"
+                          "cpuid\n\t"
+                          "movl %%ebx, %%esi\n\t"
+                          "popl %%ebx"
+                          : "=a" (p[0]), "=S" (p[1]), "=c" (p[2]), "=d" (p[3])
+                          : "a" (ax), "c" (cx) );
+#else
+    __asm__ __volatile__( "cpuid"
+                          : "=a" (p[0]), "=b" (p[1]), "=c" (p[2]), "=d" (p[3])
+                          : "a" (ax), "c" (cx) );
+#endif
+}
+#endif
+
 void msvcrt_init_math( void *module )
 {
     sse2_supported = IsProcessorFeaturePresent( PF_XMMI64_INSTRUCTIONS_AVAILABLE );
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__i386__) || defined(__x86_64__))
+    if (sse2_supported)
+    {
+        unsigned int regs[4];
+
+        /* Enhanced REP MOVSB/STOSB, used by memmove and memset. */
+        do_cpuid( 0, 0, regs );
+        if (regs[0] >= 7)
+        {
+            do_cpuid( 7, 0, regs );
+            erms_supported = (regs[1] >> 9) & 1;
+        }
+    }
+#endif
 #if _MSVCR_VER <=71
     sse2_enabled = FALSE;
 #else
@@ -1507,13 +1507,27 @@ int CDECL _atoldbl(_LDOUBLE *value, char *str)
     return _atoldbl_l( (MSVCRT__LDOUBLE*)value, str, NULL );
 }
 
+/* Word-at-a-time helpers. Only aligned words are read, so the scans never
+ * cross into a page that the byte-wise loop wouldn't have touched. */
+#define WORD_ONES  (~(size_t)0 / 0xff)
+#define WORD_HIGHS (WORD_ONES * 0x80)
+
+static inline BOOL word_has_zero_byte(size_t w)
+{
+    return ((w - WORD_ONES) & ~w & WORD_HIGHS) != 0;
+}
+
 /*********************************************************************
  *              strlen (MSVCRT.@)
  */
 size_t __cdecl strlen(const char *str)
 {
     const char *s = str;
-    while (*s) s++;
+    const size_t *w;
+
+    for (; (size_t)s % sizeof(size_t); s++) if (!*s) return s - str;
+    for (w = (const size_t *)s; !word_has_zero_byte(*w); w++) ;
+    for (s = (const char *)w; *s; s++) ;
     return s - str;
 }
 
@@ -2471,9 +2485,15 @@ int CDECL I10_OUTPUT(MSVCRT__LDOUBLE ld80, int prec, int flag, struct _I10_OUTPU
  */
 int __cdecl memcmp(const void *ptr1, const void *ptr2, size_t n)
 {
-    const unsigned char *p1, *p2;
+    typedef size_t DECLSPEC_ALIGN(1) unaligned_size_t;
+    const unsigned char *p1 = ptr1, *p2 = ptr2;
+
+    /* Skip over the common prefix a word at a time. The reads stay within
+     * the n bytes being compared. */
+    for (; n >= sizeof(size_t); n -= sizeof(size_t), p1 += sizeof(size_t), p2 += sizeof(size_t))
+        if (*(const unaligned_size_t *)p1 != *(const unaligned_size_t *)p2) break;
 
-    for (p1 = ptr1, p2 = ptr2; n; n--, p1++, p2++)
+    for (; n; n--, p1++, p2++)
     {
         if (*p1 < *p2) return -1;
         if (*p1 > *p2) return 1;
@@ -2529,6 +2549,20 @@ int __cdecl memcmp(const void *ptr1, const void *ptr2, size_t n)
     __ASM_CFI(".cfi_adjust_cfa_offset -8\n\t")
 #endif
 
+/* Minimal size for which REP MOVSB/STOSB beats the vector loops on CPUs
+ * with Enhanced REP MOVSB/STOSB. */
+#define ERMS_MIN_SIZE 2048
+
+static inline void erms_movsb(void *dst, const void *src, size_t n)
+{
+    __asm__ __volatile__( "rep; movsb" : "+D" (dst), "+S" (src), "+c" (n) : : "memory" );
+}
+
+static inline void erms_stosb(void *dst, unsigned char c, size_t n)
+{
+    __asm__ __volatile__( "rep; stosb" : "+D" (dst), "+c" (n) : "a" (c) : "memory" );
+}
+
 void * __cdecl sse2_memmove(void *dst, const void *src, size_t n);
 __ASM_GLOBAL_FUNC( sse2_memmove,
         MEMMOVE_INIT
@@ -2744,6 +2778,14 @@ __ASM_GLOBAL_FUNC( sse2_memmove,
 #endif
 void * __cdecl memmove(void *dst, const void *src, size_t n)
 {
+#if defined(__i386__) || defined(__x86_64__)
+    /* Only forward copies; REP MOVSB is slow with the direction flag set. */
+    if (n >= ERMS_MIN_SIZE && erms_supported && (size_t)dst - (size_t)src >= n)
+    {
+        erms_movsb(dst, src, n);
+        return dst;
+    }
+#endif
 #ifdef __x86_64__
     return sse2_memmove(dst, src, n);
 #else
@@ -2894,6 +2936,13 @@ void *__cdecl memset(void *dst, int c, size_t n)
         *(unaligned_ui64 *)(d + n - 24) = v;
         if (n <= 64) return dst;
 
+#if defined(__i386__) || defined(__x86_64__)
+        if (n >= ERMS_MIN_SIZE && erms_supported)
+        {
+            erms_stosb(d, c, n);
+            return dst;
+        }
+#endif
         n = (n - a) & ~0x1f;
         memset_aligned_32(d + a, v, n);
         return dst;
@@ -2929,6 +2978,17 @@ void *__cdecl memset(void *dst, int c, size_t n)
  */
 char* __cdecl strchr(const char *str, int c)
 {
+    size_t v = WORD_ONES * (unsigned char)c;
+    const size_t *w;
+
+    for (; (size_t)str % sizeof(size_t); str++)
+    {
+        if (*str == (char)c) return (char*)str;
+        if (!*str) return NULL;
+    }
+    for (w = (const size_t *)str; !word_has_zero_byte(*w) && !word_has_zero_byte(*w ^ v); w++) ;
+
+    str = (const char *)w;
     do
     {
         if (*str == (char)c) return (char*)str;
@@ -2951,9 +3011,14 @@ char* __cdecl strrchr(const char *str, int c)
  */
 void* __cdecl memchr(const void *ptr, int c, size_t n)
 {
+    size_t v = WORD_ONES * (unsigned char)c;
     const unsigned char *p = ptr;
 
-    for (p = ptr; n; n--, p++) if (*p == (unsigned char)c) return (void *)(ULONG_PTR)p;
+    for (; (size_t)p % sizeof(size_t) && n; n--, p++)
+        if (*p == (unsigned char)c) return (void *)(ULONG_PTR)p;
+    for (; n >= sizeof(size_t); n -= sizeof(size_t), p += sizeof(size_t))
+        if (word_has_zero_byte(*(const size_t *)p ^ v)) break;
+    for (; n; n--, p++) if (*p == (unsigned char)c) return (void *)(ULONG_PTR)p;
     return NULL;
 }
 
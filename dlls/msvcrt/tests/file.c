@@ -493,6 +493,49 @@ static void test_asciimode2(void)
     unlink("ascii2.tst");
 }
 
+static void test_asciimode_large(void)
+{
+    static const size_t runs[] = {1, 0, 5000, 2047, 2048, 0, 3, 10000};
+    char *obuf, *ibuf, *expect;
+    size_t len = 0, exp_len = 0, i, j;
+    FILE *fp;
+
+    obuf = malloc(20000);
+    ibuf = malloc(40000);
+    expect = malloc(40000);
+
+    /* Long runs without newlines, separated by single and repeated newlines. */
+    for (i = 0; i < ARRAY_SIZE(runs); i++)
+    {
+        for (j = 0; j < runs[i]; j++)
+            obuf[len++] = expect[exp_len++] = 'a' + (i + j) % 26;
+        obuf[len++] = '\n';
+        expect[exp_len++] = '\r';
+        expect[exp_len++] = '\n';
+    }
+
+    fp = fopen("ascii3.tst", "wt");
+    ok(fwrite(obuf, 1, len, fp) == len, "fwrite failed\n");
+    fclose(fp);
+
+    fp = fopen("ascii3.tst", "rb");
+    i = fread(ibuf, 1, 40000, fp);
+    ok(i == exp_len, "read %Iu bytes, expected %Iu\n", i, exp_len);
+    ok(!memcmp(ibuf, expect, exp_len), "wrong file contents\n");
+    fclose(fp);
+
+    fp = fopen("ascii3.tst", "rt");
+    i = fread(ibuf, 1, 40000, fp);
+    ok(i == len, "read %Iu bytes, expected %Iu\n", i, len);
+    ok(!memcmp(ibuf, obuf, len), "wrong data read in text mode\n");
+    fclose(fp);
+    unlink("ascii3.tst");
+
+    free(obuf);
+    free(ibuf);
+    free(expect);
+}
+
 static void test_filemodeT(void)
 {
     char DATA  [] = {26, 't', 'e', 's' ,'t'};
@@ -2852,6 +2895,7 @@ START_TEST(file)
     test_fileops();
     test_asciimode();
     test_asciimode2();
+    test_asciimode_large();
     test_filemodeT();
     test_readmode(FALSE); /* binary mode */
     test_readmode(TRUE);  /* ascii mode */
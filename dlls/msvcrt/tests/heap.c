@@ -21,6 +21,8 @@
 #include <stdlib.h>
 #include <malloc.h>
 #include <errno.h>
+#include <stdio.h>
+#include <string.h>
 #include "wine/test.h"
 
 static void (__cdecl *p_aligned_free)(void*) = NULL;
@@ -483,10 +485,178 @@ static void test_calloc(void)
     free(ptr);
 }
 
+static void fill_block(unsigned char *ptr, size_t size, unsigned char seed)
+{
+    size_t i;
+
+    for (i = 0; i < size; i++)
+        ptr[i] = seed + i;
+}
+
+static BOOL check_block(const unsigned char *ptr, size_t size, unsigned char seed)
+{
+    size_t i;
+
+    for (i = 0; i < size; i++)
+        if (ptr[i] != (unsigned char)(seed + i)) return FALSE;
+    return TRUE;
+}
+
+#define THREAD_CACHE_BLOCKS 64
+
+static DWORD WINAPI free_blocks_thread(void *arg)
+{
+    void **blocks = arg;
+    unsigned int i;
+
+    for (i = 0; i < THREAD_CACHE_BLOCKS; i += 2)
+    {
+        free(blocks[i]);
+        blocks[i] = NULL;
+    }
+    return 0;
+}
+
+static DWORD WINAPI alloc_blocks_thread(void *arg)
+{
+    void **blocks = arg;
+    unsigned int i;
+
+    for (i = 0; i < THREAD_CACHE_BLOCKS; i++)
+    {
+        blocks[i] = malloc(i * 8 + 1);
+        ok(blocks[i] != NULL, "malloc failed\n");
+        fill_block(blocks[i], i * 8 + 1, i);
+    }
+    return 0;
+}
+
+/* Run with WINE_MSVCRT_THREAD_CACHE=1, which enables Wine's per-thread small
+ * block cache; on Windows this just exercises the normal heap. */
+static void test_thread_cache_child(void)
+{
+    void *blocks[THREAD_CACHE_BLOCKS], *mem, *mem2;
+    HANDLE thread;
+    unsigned int i;
+    DWORD ret;
+
+    for (i = 0; i < THREAD_CACHE_BLOCKS; i++)
+    {
+        blocks[i] = malloc(i * 8 + 1);
+        ok(blocks[i] != NULL, "malloc failed\n");
+        ok(_msize(blocks[i]) == i * 8 + 1, "got size %Iu for %u\n", _msize(blocks[i]), i * 8 + 1);
+        fill_block(blocks[i], i * 8 + 1, i);
+    }
+
+    /* Free every other block from another thread. */
+    thread = CreateThread(NULL, 0, free_blocks_thread, blocks, 0, NULL);
+    ret = WaitForSingleObject(thread, 5000);
+    ok(!ret, "wait failed\n");
+    CloseHandle(thread);
+
+    for (i = 1; i < THREAD_CACHE_BLOCKS; i += 2)
+        ok(check_block(blocks[i], i * 8 + 1, i), "block %u was corrupted\n", i);
+
+    /* Reallocate the freed blocks; this may reuse the remotely freed ones. */
+    for (i = 0; i < THREAD_CACHE_BLOCKS; i += 2)
+    {
+        blocks[i] = malloc(i * 8 + 1);
+        ok(blocks[i] != NULL, "malloc failed\n");
+        fill_block(blocks[i], i * 8 + 1, i + 1);
+    }
+    for (i = 0; i < THREAD_CACHE_BLOCKS; i++)
+    {
+        ok(check_block(blocks[i], i * 8 + 1, i + !(i % 2)), "block %u was corrupted\n", i);
+        free(blocks[i]);
+    }
+
+    /* Blocks allocated by a thread which has exited. */
+    thread = CreateThread(NULL, 0, alloc_blocks_thread, blocks, 0, NULL);
+    ret = WaitForSingleObject(thread, 5000);
+    ok(!ret, "wait failed\n");
+    CloseHandle(thread);
+    thread = CreateThread(NULL, 0, free_blocks_thread, blocks, 0, NULL);
+    ret = WaitForSingleObject(thread, 5000);
+    ok(!ret, "wait failed\n");
+    CloseHandle(thread);
+    for (i = 1; i < THREAD_CACHE_BLOCKS; i += 2)
+    {
+        ok(check_block(blocks[i], i * 8 + 1, i), "block %u was corrupted\n", i);
+        free(blocks[i]);
+    }
+
+    /* realloc across the size limit of the cache. */
+    mem = malloc(500);
+    ok(mem != NULL, "malloc failed\n");
+    fill_block(mem, 500, 3);
+    mem = realloc(mem, 600);
+    ok(mem != NULL, "realloc failed\n");
+    ok(_msize(mem) == 600, "got size %Iu\n", _msize(mem));
+    ok(check_block(mem, 500, 3), "data was not preserved\n");
+    mem = realloc(mem, 100);
+    ok(mem != NULL, "realloc failed\n");
+    ok(_msize(mem) == 100, "got size %Iu\n", _msize(mem));
+    ok(check_block(mem, 100, 3), "data was not preserved\n");
+    mem = realloc(mem, 512);
+    ok(mem != NULL, "realloc failed\n");
+    ok(_msize(mem) == 512, "got size %Iu\n", _msize(mem));
+    ok(check_block(mem, 100, 3), "data was not preserved\n");
+    mem = realloc(mem, 513);
+    ok(mem != NULL, "realloc failed\n");
+    ok(_msize(mem) == 513, "got size %Iu\n", _msize(mem));
+    ok(check_block(mem, 100, 3), "data was not preserved\n");
+    free(mem);
+
+    /* _expand never moves the block. */
+    mem = malloc(100);
+    ok(mem != NULL, "malloc failed\n");
+    fill_block(mem, 100, 5);
+    mem2 = _expand(mem, 50);
+    ok(mem2 == mem, "_expand returned %p, expected %p\n", mem2, mem);
+    ok(_msize(mem) == 50, "got size %Iu\n", _msize(mem));
+    ok(check_block(mem, 50, 5), "data was not preserved\n");
+    mem2 = _expand(mem, 60);
+    ok(!mem2 || mem2 == mem, "_expand returned %p, expected %p\n", mem2, mem);
+    if (mem2)
+        ok(_msize(mem) == 60, "got size %Iu\n", _msize(mem));
+    ok(check_block(mem, 50, 5), "data was not preserved\n");
+    free(mem);
+}
+
+static void test_thread_cache(void)
+{
+    PROCESS_INFORMATION pi;
+    STARTUPINFOA si = {0};
+    char cmdline[MAX_PATH + 32];
+    char **argv;
+    BOOL ret;
+
+    winetest_get_mainargs(&argv);
+    sprintf(cmdline, "\"%s\" heap thread_cache", argv[0]);
+    si.cb = sizeof(si);
+
+    SetEnvironmentVariableA("WINE_MSVCRT_THREAD_CACHE", "1");
+    ret = CreateProcessA(NULL, cmdline, NULL, NULL, FALSE, 0, NULL, NULL, &si, &pi);
+    SetEnvironmentVariableA("WINE_MSVCRT_THREAD_CACHE", NULL);
+    ok(ret, "CreateProcess failed, error %u\n", GetLastError());
+    if (!ret) return;
+
+    wait_child_process(pi.hProcess);
+    CloseHandle(pi.hProcess);
+    CloseHandle(pi.hThread);
+}
+
 START_TEST(heap)
 {
+    char **argv;
     void *mem;
 
+    if (winetest_get_mainargs(&argv) >= 3 && !strcmp(argv[2], "thread_cache"))
+    {
+        test_thread_cache_child();
+        return;
+    }
+
     mem = malloc(0);
     ok(mem != NULL, "memory not allocated for size 0\n");
     free(mem);
@@ -508,4 +678,5 @@ START_TEST(heap)
     test_aligned();
     test_sbheap();
     test_calloc();
+    test_thread_cache();
 }
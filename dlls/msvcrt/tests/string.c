@@ -118,6 +118,12 @@ static int (__cdecl *p__memicmp_l)(const char*, const char*, size_t, _locale_t);
 static size_t (__cdecl *p___strncnt)(const char*, size_t);
 static unsigned int (__cdecl *p_mbsnextc_l)(const unsigned char*, _locale_t);
 static int (__cdecl *p_mbscmp_l)(const unsigned char*, const unsigned char*, _locale_t);
+static size_t (__cdecl *p_strlen)(const char*);
+static char* (__cdecl *p_strchr)(const char*, int);
+static void* (__cdecl *p_memchr)(const void*, int, size_t);
+static void* (__cdecl *p_memset)(void*, int, size_t);
+static size_t (__cdecl *p_wcslen)(const wchar_t*);
+static wchar_t* (__cdecl *p_wcschr)(const wchar_t*, wchar_t);
 
 int CDECL __STRINGTOLD(_LDOUBLE*, char**, const char*, int);
 
@@ -4477,6 +4483,89 @@ static void test_wcsncpy(void)
             wine_dbgstr_wn(dst, ARRAY_SIZE(dst)));
 }
 
+static void test_page_edge(void)
+{
+    char *mem, *str, *buf, *ret;
+    wchar_t *wstr, *wret;
+    SYSTEM_INFO si;
+    DWORD old_prot;
+    size_t len, i;
+    int r;
+
+    GetSystemInfo(&si);
+    mem = VirtualAlloc(NULL, 2 * si.dwPageSize, MEM_COMMIT, PAGE_READWRITE);
+    ok(mem != NULL, "VirtualAlloc failed\n");
+    r = VirtualProtect(mem + si.dwPageSize, si.dwPageSize, PAGE_NOACCESS, &old_prot);
+    ok(r, "VirtualProtect failed\n");
+    buf = malloc(si.dwPageSize);
+
+    /* Strings end right before an inaccessible page, at every alignment. */
+    for (len = 0; len < 80; len++)
+    {
+        str = mem + si.dwPageSize - len - 1;
+        memset(str, 'a', len);
+        str[len] = 0;
+
+        ok(p_strlen(str) == len, "%Iu: strlen returned %Iu\n", len, p_strlen(str));
+        ret = p_strchr(str, 'b');
+        ok(!ret, "%Iu: strchr returned %p\n", len, ret);
+        ret = p_strchr(str, 0);
+        ok(ret == str + len, "%Iu: strchr returned %p, expected %p\n", len, ret, str + len);
+        ret = p_memchr(str, 'b', len + 1);
+        ok(!ret, "%Iu: memchr returned %p\n", len, ret);
+        ret = p_memchr(str, 0, len + 1);
+        ok(ret == str + len, "%Iu: memchr returned %p, expected %p\n", len, ret, str + len);
+        if (len)
+        {
+            str[len - 1] = (char)0xe1;
+            ret = p_strchr(str, 0xe1);
+            ok(ret == str + len - 1, "%Iu: strchr returned %p, expected %p\n", len, ret, str + len - 1);
+            ret = p_memchr(str, 0xe1, len);
+            ok(ret == str + len - 1, "%Iu: memchr returned %p, expected %p\n", len, ret, str + len - 1);
+            str[len - 1] = 'a';
+        }
+
+        /* Compare against a copy with a different alignment. */
+        memcpy(buf + len % 7, str, len + 1);
+        r = (INT_PTR)pmemcmp(str, buf + len % 7, len + 1);
+        ok(!r, "%Iu: memcmp returned %d\n", len, r);
+        for (i = 0; i < len; i++)
+        {
+            buf[len % 7 + i] = 'b';
+            r = (INT_PTR)pmemcmp(str, buf + len % 7, len + 1);
+            ok(r < 0, "%Iu,%Iu: memcmp returned %d\n", len, i, r);
+            buf[len % 7 + i] = 'a';
+        }
+
+        wstr = (wchar_t *)(mem + si.dwPageSize) - len - 1;
+        for (i = 0; i < len; i++) wstr[i] = 0x141;
+        wstr[len] = 0;
+        ok(p_wcslen(wstr) == len, "%Iu: wcslen returned %Iu\n", len, p_wcslen(wstr));
+        wret = p_wcschr(wstr, 0x4101);
+        ok(!wret, "%Iu: wcschr returned %p\n", len, wret);
+        wret = p_wcschr(wstr, 0);
+        ok(wret == wstr + len, "%Iu: wcschr returned %p, expected %p\n", len, wret, wstr + len);
+    }
+
+    /* memset at all head alignments, including large sizes. */
+    for (len = 0; len < si.dwPageSize - 16; len += (len < 100 ? 1 : 509))
+    {
+        for (i = 0; i < 8; i++)
+        {
+            size_t j;
+
+            memset(mem, 'x', si.dwPageSize);
+            p_memset(mem + i, 'y', len);
+            for (j = 0; j < si.dwPageSize; j++)
+                if (mem[j] != (j >= i && j < i + len ? 'y' : 'x')) break;
+            ok(j == si.dwPageSize, "%Iu,%Iu: wrong byte at %Iu\n", len, i, j);
+        }
+    }
+
+    free(buf);
+    VirtualFree(mem, 0, MEM_RELEASE);
+}
+
 START_TEST(string)
 {
     char mem[100];
@@ -4550,6 +4639,12 @@ START_TEST(string)
     p___strncnt = (void*)GetProcAddress(hMsvcrt, "__strncnt");
     p_mbsnextc_l = (void*)GetProcAddress(hMsvcrt, "_mbsnextc_l");
     p_mbscmp_l = (void*)GetProcAddress(hMsvcrt, "_mbscmp_l");
+    SET(p_strlen, "strlen");
+    SET(p_strchr, "strchr");
+    SET(p_memchr, "memchr");
+    SET(p_memset, "memset");
+    SET(p_wcslen, "wcslen");
+    SET(p_wcschr, "wcschr");
 
     /* MSVCRT memcpy behaves like memmove for overlapping moves,
        MFC42 CString::Insert seems to rely on that behaviour */
@@ -4633,4 +4728,5 @@ START_TEST(string)
     test_SpecialCasing();
     test__mbbtype();
     test_wcsncpy();
+    test_page_edge();
 }
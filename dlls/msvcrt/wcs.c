@@ -2820,11 +2820,34 @@ wint_t CDECL towupper(wint_t c)
     return _towupper_l(c, NULL);
 }
 
+/* Word-at-a-time helpers, see string.c. Only aligned words are read. */
+#define WORD_WCHAR_ONES  (~(size_t)0 / 0xffff)
+#define WORD_WCHAR_HIGHS (WORD_WCHAR_ONES * 0x8000)
+
+static inline BOOL word_has_zero_wchar(size_t w)
+{
+    return ((w - WORD_WCHAR_ONES) & ~w & WORD_WCHAR_HIGHS) != 0;
+}
+
 /*********************************************************************
  *              wcschr (MSVCRT.@)
  */
 wchar_t* CDECL wcschr(const wchar_t *str, wchar_t ch)
 {
+    size_t v = WORD_WCHAR_ONES * ch;
+    const size_t *w;
+
+    if (!((size_t)str % sizeof(wchar_t)))
+    {
+        for (; (size_t)str % sizeof(size_t); str++)
+        {
+            if (*str == ch) return (WCHAR *)(ULONG_PTR)str;
+            if (!*str) return NULL;
+        }
+        for (w = (const size_t *)str; !word_has_zero_wchar(*w) && !word_has_zero_wchar(*w ^ v); w++) ;
+        str = (const wchar_t *)w;
+    }
+
     do { if (*str == ch) return (WCHAR *)(ULONG_PTR)str; } while (*str++);
     return NULL;
 }
@@ -2845,6 +2868,15 @@ wchar_t* CDECL wcsrchr(const wchar_t *str, wchar_t ch)
 size_t CDECL wcslen(const wchar_t *str)
 {
     const wchar_t *s = str;
+    const size_t *w;
+
+    if (!((size_t)s % sizeof(wchar_t)))
+    {
+        for (; (size_t)s % sizeof(size_t); s++) if (!*s) return s - str;
+        for (w = (const size_t *)s; !word_has_zero_wchar(*w); w++) ;
+        s = (const wchar_t *)w;
+    }
+
     while (*s) s++;
     return s - str;
 }
@@ -38,6 +38,9 @@
 #ifdef HAVE_SYS_SOCKET_H
 #include <sys/socket.h>
 #endif
+#ifdef HAVE_SYS_SENDFILE_H
+# include <sys/sendfile.h>
+#endif
 #ifdef HAVE_NETINET_IN_H
 # define __APPLE_USE_RFC_3542
 # include <netinet/in.h>
@@ -144,6 +147,7 @@ struct async_transmit_ioctl
     unsigned int buffer_cursor; /* amount of data currently in the buffer already sent */
     unsigned int tail_cursor;   /* amount of tail data already sent */
     unsigned int file_len;      /* total file length to send */
+    BOOL no_sendfile;           /* sendfile() is not supported for this file */
     DWORD flags;
     TRANSMIT_FILE_BUFFERS buffers;
     LARGE_INTEGER offset;
@@ -1005,6 +1009,51 @@ static NTSTATUS try_transmit( int sock_fd, int file_fd, struct async_transmit_io
         async->file_cursor += ret;
     }
 
+#ifdef HAVE_SYS_SENDFILE_H
+    /* send the file data directly from the page cache, without copying it
+     * through our buffer */
+    while (async->file && !async->no_sendfile && async->buffer_cursor == async->read_len)
+    {
+        size_t send_size = async->buffer_size;
+        off_t offset;
+
+        if (async->file_len)
+            send_size = min( send_size, async->file_len - async->file_cursor );
+
+        TRACE( "sending %zu bytes of file data with sendfile\n", send_size );
+        do
+        {
+            if (async->offset.QuadPart == FILE_USE_FILE_POINTER_POSITION)
+                ret = sendfile( sock_fd, file_fd, NULL, send_size );
+            else
+            {
+                offset = async->offset.QuadPart;
+                ret = sendfile( sock_fd, file_fd, &offset, send_size );
+            }
+        } while (ret < 0 && errno == EINTR);
+
+        if (ret < 0)
+        {
+            if (errno != EINVAL && errno != ENOSYS)
+            {
+                if (errno != EWOULDBLOCK) WARN( "sendfile: %s\n", strerror( errno ) );
+                return sock_errno_to_status( errno );
+            }
+            TRACE( "sendfile not supported, falling back to read\n" );
+            async->no_sendfile = TRUE;
+            break;
+        }
+        TRACE( "sendfile returned %zd\n", ret );
+
+        async->file_cursor += ret;
+        if (async->offset.QuadPart != FILE_USE_FILE_POINTER_POSITION)
+            async->offset.QuadPart += ret;
+
+        if (!ret || (async->file_len && async->file_cursor == async->file_len))
+            async->file = NULL;
+    }
+#endif
+
     if (async->file && async->buffer_cursor == async->read_len)
     {
         unsigned int read_size = async->buffer_size;
@@ -1123,6 +1172,7 @@ static NTSTATUS sock_transmit( HANDLE handle, HANDLE event, PIO_APC_ROUTINE apc,
     async->buffer_cursor = 0;
     async->tail_cursor = 0;
     async->file_len = params->file_len;
+    async->no_sendfile = FALSE;
     async->flags = params->flags;
     async->buffers = params->buffers;
     async->offset = params->offset;
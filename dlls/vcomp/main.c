@@ -44,6 +44,7 @@ static HMODULE vcomp_module;
 static int     vcomp_max_threads;
 static int     vcomp_num_threads;
 static int     vcomp_num_procs;
+static int     vcomp_spin_count;
 static BOOL    vcomp_nested_fork = FALSE;
 
 static RTL_CRITICAL_SECTION vcomp_section;
@@ -60,6 +61,11 @@ static RTL_CRITICAL_SECTION vcomp_section = { &critsect_debug, -1, 0, 0, 0, 0 };
 #define VCOMP_DYNAMIC_FLAGS_GUIDED      0x03
 #define VCOMP_DYNAMIC_FLAGS_INCREMENT   0x40
 
+/* Number of iterations to busy-wait before blocking, when there is more than
+ * one processor. Fork/join and barriers are usually resolved within that time
+ * in fine-grained parallel loops. */
+#define VCOMP_SPIN_COUNT                4000
+
 struct vcomp_thread_data
 {
     struct vcomp_team_data  *team;
@@ -89,7 +95,7 @@ struct vcomp_team_data
 {
     CONDITION_VARIABLE      cond;
     int                     num_threads;
-    int                     finished_threads;
+    LONG                    finished_threads;
 
     /* callback arguments */
     int                     nargs;
@@ -97,8 +103,8 @@ struct vcomp_team_data
     va_list                 valist;
 
     /* barrier */
-    unsigned int            barrier;
-    int                     barrier_count;
+    LONG                    barrier;
+    LONG                    barrier_count;
 };
 
 struct vcomp_task_data
@@ -1057,26 +1063,31 @@ void CDECL _vcomp_flush(void)
 void CDECL _vcomp_barrier(void)
 {
     struct vcomp_team_data *team_data = vcomp_init_thread_data()->team;
+    LONG barrier;
+    int i;
 
     TRACE("()\n");
 
     if (!team_data)
         return;
 
-    EnterCriticalSection(&vcomp_section);
-    if (++team_data->barrier_count >= team_data->num_threads)
+    /* The generation can't advance before this thread has arrived, so it is
+     * safe to read it before incrementing the counter. */
+    barrier = *(volatile LONG *)&team_data->barrier;
+    if (InterlockedIncrement(&team_data->barrier_count) >= team_data->num_threads)
     {
-        team_data->barrier++;
         team_data->barrier_count = 0;
-        WakeAllConditionVariable(&team_data->cond);
+        InterlockedIncrement(&team_data->barrier);
+        RtlWakeAddressAll(&team_data->barrier);
     }
     else
     {
-        unsigned int barrier = team_data->barrier;
-        while (team_data->barrier == barrier)
-            SleepConditionVariableCS(&team_data->cond, &vcomp_section, INFINITE);
+        for (i = 0; i < vcomp_spin_count && *(volatile LONG *)&team_data->barrier == barrier; ++i)
+            YieldProcessor();
+        while (*(volatile LONG *)&team_data->barrier == barrier)
+            RtlWaitOnAddress(&team_data->barrier, &barrier, sizeof(barrier), NULL);
+        MemoryBarrier();
     }
-    LeaveCriticalSection(&vcomp_section);
 }
 
 void CDECL _vcomp_set_num_threads(int num_threads)
@@ -1536,6 +1547,8 @@ int CDECL omp_in_parallel(void)
 static DWORD WINAPI _vcomp_fork_worker(void *param)
 {
     struct vcomp_thread_data *thread_data = param;
+    int i;
+
     vcomp_set_thread_data(thread_data);
 
     TRACE("starting worker thread for %p\n", thread_data);
@@ -1553,8 +1566,17 @@ static DWORD WINAPI _vcomp_fork_worker(void *param)
             thread_data->team = NULL;
             list_remove(&thread_data->entry);
             list_add_tail(&vcomp_idle_threads, &thread_data->entry);
-            if (++team->finished_threads >= team->num_threads)
+            if (InterlockedIncrement(&team->finished_threads) >= team->num_threads)
                 WakeAllConditionVariable(&team->cond);
+
+            /* Applications often fork again right away, so wait for the next
+             * team for a while without going to sleep. */
+            LeaveCriticalSection(&vcomp_section);
+            for (i = 0; i < vcomp_spin_count && !*(struct vcomp_team_data *volatile *)&thread_data->team; ++i)
+                YieldProcessor();
+            EnterCriticalSection(&vcomp_section);
+            if (thread_data->team)
+                continue;
         }
 
         if (!SleepConditionVariableCS(&thread_data->cond, &vcomp_section, 5000) &&
@@ -1687,9 +1709,15 @@ void WINAPIV _vcomp_fork(BOOL ifval, int nargs, void *wrapper, ...)
 
     if (team_data.num_threads > 1)
     {
-        EnterCriticalSection(&vcomp_section);
+        int i;
 
-        team_data.finished_threads++;
+        InterlockedIncrement(&team_data.finished_threads);
+        for (i = 0; i < vcomp_spin_count && *(volatile LONG *)&team_data.finished_threads < team_data.num_threads; ++i)
+            YieldProcessor();
+
+        /* Workers signal completion under vcomp_section, so they are done with
+         * team_data once we hold it. */
+        EnterCriticalSection(&vcomp_section);
         while (team_data.finished_threads < team_data.num_threads)
             SleepConditionVariableCS(&team_data.cond, &vcomp_section, INFINITE);
 
@@ -1970,6 +1998,7 @@ BOOL WINAPI DllMain(HINSTANCE instance, DWORD reason, LPVOID reserved)
             vcomp_max_threads = sysinfo.dwNumberOfProcessors;
             vcomp_num_threads = sysinfo.dwNumberOfProcessors;
             vcomp_num_procs   = sysinfo.dwNumberOfProcessors;
+            vcomp_spin_count  = sysinfo.dwNumberOfProcessors > 1 ? VCOMP_SPIN_COUNT : 0;
             break;
         }
 
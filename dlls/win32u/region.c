@@ -1579,7 +1579,8 @@ static BOOL REGION_RegionOp(
 	    BOOL (*nonOverlap1Func)(WINEREGION*, RECT*, RECT*, INT, INT), /* Function to call for non-overlapping bands in region 1 */
 	    BOOL (*nonOverlap2Func)(WINEREGION*, RECT*, RECT*, INT, INT)  /* Function to call for non-overlapping bands in region 2 */
 ) {
-    WINEREGION newReg;
+    WINEREGION tmpReg;                /* Temporary storage when destReg is a source */
+    WINEREGION *newReg;               /* Region being built */
     RECT *r1;                         /* Pointer into first region */
     RECT *r2;                         /* Pointer into 2d region */
     RECT *r1End;                      /* End of 1st region */
@@ -1607,14 +1608,27 @@ static BOOL REGION_RegionOp(
     r1End = r1 + reg1->numRects;
     r2End = r2 + reg2->numRects;
 
-    /*
-     * Allocate a reasonable number of rectangles for the new region. The idea
-     * is to allocate enough so the individual functions don't need to
-     * reallocate and copy the array, which is time consuming, yet we don't
-     * have to worry about using too much memory. I hope to be able to
-     * nuke the Xrealloc() at the end of this function eventually.
-     */
-    if (!init_region( &newReg, max(reg1->numRects,reg2->numRects) * 2 )) return FALSE;
+    if (destReg == reg1 || destReg == reg2)
+    {
+        /*
+         * Allocate a reasonable number of rectangles for the new region. The idea
+         * is to allocate enough so the individual functions don't need to
+         * reallocate and copy the array, which is time consuming, yet we don't
+         * have to worry about using too much memory.
+         */
+        if (!init_region( &tmpReg, max(reg1->numRects,reg2->numRects) * 2 )) return FALSE;
+        newReg = &tmpReg;
+    }
+    else
+    {
+        /*
+         * The destination is not used as a source, so build the result in
+         * place and reuse its array of rectangles; it only gets reallocated
+         * when it is too small to hold the result.
+         */
+        empty_region( destReg );
+        newReg = destReg;
+    }
 
     /*
      * Initialize ybot and ytop.
@@ -1647,7 +1661,7 @@ static BOOL REGION_RegionOp(
 
     do
     {
-	curBand = newReg.numRects;
+	curBand = newReg->numRects;
 
 	/*
 	 * This algorithm proceeds one source-band (as opposed to a
@@ -1683,7 +1697,7 @@ static BOOL REGION_RegionOp(
 
             if ((top != bot) && (nonOverlap1Func != NULL))
 	    {
-		if (!nonOverlap1Func(&newReg, r1, r1BandEnd, top, bot)) return FALSE;
+		if (!nonOverlap1Func(newReg, r1, r1BandEnd, top, bot)) goto failed;
 	    }
 
 	    ytop = r2->top;
@@ -1695,7 +1709,7 @@ static BOOL REGION_RegionOp(
 
             if ((top != bot) && (nonOverlap2Func != NULL))
 	    {
-		if (!nonOverlap2Func(&newReg, r2, r2BandEnd, top, bot)) return FALSE;
+		if (!nonOverlap2Func(newReg, r2, r2BandEnd, top, bot)) goto failed;
 	    }
 
 	    ytop = r1->top;
@@ -1711,9 +1725,9 @@ static BOOL REGION_RegionOp(
 	 * this test in miCoalesce, but some machines incur a not
 	 * inconsiderable cost for function calls, so...
 	 */
-	if (newReg.numRects != curBand)
+	if (newReg->numRects != curBand)
 	{
-	    prevBand = REGION_Coalesce (&newReg, prevBand, curBand);
+	    prevBand = REGION_Coalesce (newReg, prevBand, curBand);
 	}
 
 	/*
@@ -1721,15 +1735,15 @@ static BOOL REGION_RegionOp(
 	 * intersect if ybot > ytop
 	 */
 	ybot = min(r1->bottom, r2->bottom);
-	curBand = newReg.numRects;
+	curBand = newReg->numRects;
 	if (ybot > ytop)
 	{
-	    if (!overlapFunc(&newReg, r1, r1BandEnd, r2, r2BandEnd, ytop, ybot)) return FALSE;
+	    if (!overlapFunc(newReg, r1, r1BandEnd, r2, r2BandEnd, ytop, ybot)) goto failed;
 	}
 
-	if (newReg.numRects != curBand)
+	if (newReg->numRects != curBand)
 	{
-	    prevBand = REGION_Coalesce (&newReg, prevBand, curBand);
+	    prevBand = REGION_Coalesce (newReg, prevBand, curBand);
 	}
 
 	/*
@@ -1749,7 +1763,7 @@ static BOOL REGION_RegionOp(
     /*
      * Deal with whichever region still has rectangles left.
      */
-    curBand = newReg.numRects;
+    curBand = newReg->numRects;
     if (r1 != r1End)
     {
         if (nonOverlap1Func != NULL)
@@ -1761,8 +1775,8 @@ static BOOL REGION_RegionOp(
 		{
 		    r1BandEnd++;
 		}
-		if (!nonOverlap1Func(&newReg, r1, r1BandEnd, max(r1->top,ybot), r1->bottom))
-                    return FALSE;
+		if (!nonOverlap1Func(newReg, r1, r1BandEnd, max(r1->top,ybot), r1->bottom))
+                    goto failed;
 		r1 = r1BandEnd;
 	    } while (r1 != r1End);
 	}
@@ -1776,20 +1790,25 @@ static BOOL REGION_RegionOp(
 	    {
 		 r2BandEnd++;
 	    }
-	    if (!nonOverlap2Func(&newReg, r2, r2BandEnd, max(r2->top,ybot), r2->bottom))
-                return FALSE;
+	    if (!nonOverlap2Func(newReg, r2, r2BandEnd, max(r2->top,ybot), r2->bottom))
+                goto failed;
 	    r2 = r2BandEnd;
 	} while (r2 != r2End);
     }
 
-    if (newReg.numRects != curBand)
+    if (newReg->numRects != curBand)
     {
-	REGION_Coalesce (&newReg, prevBand, curBand);
+	REGION_Coalesce (newReg, prevBand, curBand);
     }
 
-    REGION_compact( &newReg );
-    move_rects( destReg, &newReg );
+    REGION_compact( newReg );
+    if (newReg == &tmpReg) move_rects( destReg, &tmpReg );
     return TRUE;
+
+failed:
+    if (newReg == &tmpReg) destroy_region( &tmpReg );
+    else empty_region( destReg );
+    return FALSE;
 }
 
 /***********************************************************************
@@ -136,6 +136,87 @@ static inline FormatConverter *impl_from_IWICFormatConverter(IWICFormatConverter
     return CONTAINING_RECORD(iface, FormatConverter, IWICFormatConverter_iface);
 }
 
+/* Row helpers for the most common conversions. They are kept as plain
+ * indexed loops without branches, so that the compiler can vectorize them. */
+static void convert_row_bgr24_to_bgra32(BYTE *dst, const BYTE *src, UINT width)
+{
+    UINT x;
+
+    for (x = 0; x < width; x++)
+    {
+        dst[4 * x] = src[3 * x];
+        dst[4 * x + 1] = src[3 * x + 1];
+        dst[4 * x + 2] = src[3 * x + 2];
+        dst[4 * x + 3] = 0xff;
+    }
+}
+
+static void convert_row_rgb24_to_bgra32(BYTE *dst, const BYTE *src, UINT width)
+{
+    UINT x;
+
+    for (x = 0; x < width; x++)
+    {
+        dst[4 * x] = src[3 * x + 2];
+        dst[4 * x + 1] = src[3 * x + 1];
+        dst[4 * x + 2] = src[3 * x];
+        dst[4 * x + 3] = 0xff;
+    }
+}
+
+static void convert_row_bgrx32_to_bgr24(BYTE *dst, const BYTE *src, UINT width)
+{
+    UINT x;
+
+    for (x = 0; x < width; x++)
+    {
+        dst[3 * x] = src[4 * x];
+        dst[3 * x + 1] = src[4 * x + 1];
+        dst[3 * x + 2] = src[4 * x + 2];
+    }
+}
+
+/* Also converts RGBX to BGR. */
+static void convert_row_bgrx32_to_rgb24(BYTE *dst, const BYTE *src, UINT width)
+{
+    UINT x;
+
+    for (x = 0; x < width; x++)
+    {
+        dst[3 * x] = src[4 * x + 2];
+        dst[3 * x + 1] = src[4 * x + 1];
+        dst[3 * x + 2] = src[4 * x];
+    }
+}
+
+static void set_opaque_alpha(BYTE *data, UINT stride, UINT width, UINT height)
+{
+    UINT x, y;
+
+    for (y = 0; y < height; y++, data += stride)
+        for (x = 0; x < width; x++)
+            data[4 * x + 3] = 0xff;
+}
+
+static void premultiply_alpha(BYTE *data, UINT stride, UINT width, UINT height)
+{
+    UINT x, y;
+
+    /* For alpha == 255, c * alpha / 255 == c, so there's no need to treat
+     * opaque pixels specially. */
+    for (y = 0; y < height; y++, data += stride)
+    {
+        for (x = 0; x < width; x++)
+        {
+            UINT alpha = data[4 * x + 3];
+
+            data[4 * x] = data[4 * x] * alpha / 255;
+            data[4 * x + 1] = data[4 * x + 1] * alpha / 255;
+            data[4 * x + 2] = data[4 * x + 2] * alpha / 255;
+        }
+    }
+}
+
 static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRect *prc,
     UINT cbStride, UINT cbBufferSize, BYTE *pbBuffer, enum pixelformat source_format)
 {
@@ -618,13 +699,11 @@ static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRe
         if (prc)
         {
             HRESULT res;
-            INT x, y;
+            INT y;
             BYTE *srcdata;
             UINT srcstride, srcdatasize;
             const BYTE *srcrow;
-            const BYTE *srcpixel;
             BYTE *dstrow;
-            BYTE *dstpixel;
 
             srcstride = 3 * prc->Width;
             srcdatasize = srcstride * prc->Height;
@@ -639,14 +718,7 @@ static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRe
                 srcrow = srcdata;
                 dstrow = pbBuffer;
                 for (y=0; y<prc->Height; y++) {
-                    srcpixel=srcrow;
-                    dstpixel=dstrow;
-                    for (x=0; x<prc->Width; x++) {
-                        *dstpixel++=*srcpixel++; /* blue */
-                        *dstpixel++=*srcpixel++; /* green */
-                        *dstpixel++=*srcpixel++; /* red */
-                        *dstpixel++=255; /* alpha */
-                    }
+                    convert_row_bgr24_to_bgra32(dstrow, srcrow, prc->Width);
                     srcrow += srcstride;
                     dstrow += cbStride;
                 }
@@ -661,14 +733,11 @@ static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRe
         if (prc)
         {
             HRESULT res;
-            INT x, y;
+            INT y;
             BYTE *srcdata;
             UINT srcstride, srcdatasize;
             const BYTE *srcrow;
-            const BYTE *srcpixel;
             BYTE *dstrow;
-            BYTE *dstpixel;
-            BYTE tmppixel[3];
 
             srcstride = 3 * prc->Width;
             srcdatasize = srcstride * prc->Height;
@@ -683,18 +752,7 @@ static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRe
                 srcrow = srcdata;
                 dstrow = pbBuffer;
                 for (y=0; y<prc->Height; y++) {
-                    srcpixel=srcrow;
-                    dstpixel=dstrow;
-                    for (x=0; x<prc->Width; x++) {
-                        tmppixel[0]=*srcpixel++; /* red */
-                        tmppixel[1]=*srcpixel++; /* green */
-                        tmppixel[2]=*srcpixel++; /* blue */
-
-                        *dstpixel++=tmppixel[2]; /* blue */
-                        *dstpixel++=tmppixel[1]; /* green */
-                        *dstpixel++=tmppixel[0]; /* red */
-                        *dstpixel++=255; /* alpha */
-                    }
+                    convert_row_rgb24_to_bgra32(dstrow, srcrow, prc->Width);
                     srcrow += srcstride;
                     dstrow += cbStride;
                 }
@@ -709,15 +767,11 @@ static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRe
         if (prc)
         {
             HRESULT res;
-            INT x, y;
 
             res = IWICBitmapSource_CopyPixels(This->source, prc, cbStride, cbBufferSize, pbBuffer);
             if (FAILED(res)) return res;
 
-            /* set all alpha values to 255 */
-            for (y=0; y<prc->Height; y++)
-                for (x=0; x<prc->Width; x++)
-                    pbBuffer[cbStride*y+4*x+3] = 0xff;
+            set_opaque_alpha(pbBuffer, cbStride, prc->Width, prc->Height);
         }
         return S_OK;
     case format_32bppRGBA:
@@ -881,15 +935,10 @@ static HRESULT copypixels_to_32bppRGBA(struct FormatConverter *This, const WICRe
     case format_32bppRGB:
         if (prc)
         {
-            INT x, y;
-
             hr = IWICBitmapSource_CopyPixels(This->source, prc, cbStride, cbBufferSize, pbBuffer);
             if (FAILED(hr)) return hr;
 
-            /* set all alpha values to 255 */
-            for (y=0; y<prc->Height; y++)
-                for (x=0; x<prc->Width; x++)
-                    pbBuffer[cbStride*y+4*x+3] = 0xff;
+            set_opaque_alpha(pbBuffer, cbStride, prc->Width, prc->Height);
         }
         return S_OK;
 
@@ -974,21 +1023,7 @@ static HRESULT copypixels_to_32bppPBGRA(struct FormatConverter *This, const WICR
     default:
         hr = copypixels_to_32bppBGRA(This, prc, cbStride, cbBufferSize, pbBuffer, source_format);
         if (SUCCEEDED(hr) && prc)
-        {
-            INT x, y;
-
-            for (y=0; y<prc->Height; y++)
-                for (x=0; x<prc->Width; x++)
-                {
-                    BYTE alpha = pbBuffer[cbStride*y+4*x+3];
-                    if (alpha != 255)
-                    {
-                        pbBuffer[cbStride*y+4*x] = pbBuffer[cbStride*y+4*x] * alpha / 255;
-                        pbBuffer[cbStride*y+4*x+1] = pbBuffer[cbStride*y+4*x+1] * alpha / 255;
-                        pbBuffer[cbStride*y+4*x+2] = pbBuffer[cbStride*y+4*x+2] * alpha / 255;
-                    }
-                }
-        }
+            premultiply_alpha(pbBuffer, cbStride, prc->Width, prc->Height);
         return hr;
     }
 }
@@ -1007,21 +1042,7 @@ static HRESULT copypixels_to_32bppPRGBA(struct FormatConverter *This, const WICR
     default:
         hr = copypixels_to_32bppRGBA(This, prc, cbStride, cbBufferSize, pbBuffer, source_format);
         if (SUCCEEDED(hr) && prc)
-        {
-            INT x, y;
-
-            for (y=0; y<prc->Height; y++)
-                for (x=0; x<prc->Width; x++)
-                {
-                    BYTE alpha = pbBuffer[cbStride*y+4*x+3];
-                    if (alpha != 255)
-                    {
-                        pbBuffer[cbStride*y+4*x] = pbBuffer[cbStride*y+4*x] * alpha / 255;
-                        pbBuffer[cbStride*y+4*x+1] = pbBuffer[cbStride*y+4*x+1] * alpha / 255;
-                        pbBuffer[cbStride*y+4*x+2] = pbBuffer[cbStride*y+4*x+2] * alpha / 255;
-                    }
-                }
-        }
+            premultiply_alpha(pbBuffer, cbStride, prc->Width, prc->Height);
         return hr;
     }
 }
@@ -1050,13 +1071,11 @@ static HRESULT copypixels_to_24bppBGR(struct FormatConverter *This, const WICRec
         if (prc)
         {
             HRESULT res;
-            INT x, y;
+            INT y;
             BYTE *srcdata;
             UINT srcstride, srcdatasize;
             const BYTE *srcrow;
-            const BYTE *srcpixel;
             BYTE *dstrow;
-            BYTE *dstpixel;
 
             srcstride = 4 * prc->Width;
             srcdatasize = srcstride * prc->Height;
@@ -1071,37 +1090,14 @@ static HRESULT copypixels_to_24bppBGR(struct FormatConverter *This, const WICRec
                 srcrow = srcdata;
                 dstrow = pbBuffer;
 
-                if (source_format == format_32bppRGBA)
-                {
-                    for (y = 0; y < prc->Height; y++)
-                    {
-                        srcpixel = srcrow;
-                        dstpixel = dstrow;
-                        for (x = 0; x < prc->Width; x++) {
-                            *dstpixel++ = srcpixel[2]; /* blue */
-                            *dstpixel++ = srcpixel[1]; /* green */
-                            *dstpixel++ = srcpixel[0]; /* red */
-                            srcpixel += 4;
-                        }
-                        srcrow += srcstride;
-                        dstrow += cbStride;
-                    }
-                }
-                else
+                for (y = 0; y < prc->Height; y++)
                 {
-                    for (y = 0; y < prc->Height; y++)
-                    {
-                        srcpixel = srcrow;
-                        dstpixel = dstrow;
-                        for (x = 0; x < prc->Width; x++) {
-                            *dstpixel++ = *srcpixel++; /* blue */
-                            *dstpixel++ = *srcpixel++; /* green */
-                            *dstpixel++ = *srcpixel++; /* red */
-                            srcpixel++; /* alpha */
-                        }
-                        srcrow += srcstride;
-                        dstrow += cbStride;
-                    }
+                    if (source_format == format_32bppRGBA)
+                        convert_row_bgrx32_to_rgb24(dstrow, srcrow, prc->Width);
+                    else
+                        convert_row_bgrx32_to_bgr24(dstrow, srcrow, prc->Width);
+                    srcrow += srcstride;
+                    dstrow += cbStride;
                 }
             }
 
@@ -1224,14 +1220,11 @@ static HRESULT copypixels_to_24bppRGB(struct FormatConverter *This, const WICRec
         if (prc)
         {
             HRESULT res;
-            INT x, y;
+            INT y;
             BYTE *srcdata;
             UINT srcstride, srcdatasize;
             const BYTE *srcrow;
-            const BYTE *srcpixel;
             BYTE *dstrow;
-            BYTE *dstpixel;
-            BYTE tmppixel[3];
 
             srcstride = 4 * prc->Width;
             srcdatasize = srcstride * prc->Height;
@@ -1246,18 +1239,7 @@ static HRESULT copypixels_to_24bppRGB(struct FormatConverter *This, const WICRec
                 srcrow = srcdata;
                 dstrow = pbBuffer;
                 for (y=0; y<prc->Height; y++) {
-                    srcpixel=srcrow;
-                    dstpixel=dstrow;
-                    for (x=0; x<prc->Width; x++) {
-                        tmppixel[0]=*srcpixel++; /* blue */
-                        tmppixel[1]=*srcpixel++; /* green */
-                        tmppixel[2]=*srcpixel++; /* red */
-                        srcpixel++; /* alpha */
-
-                        *dstpixel++=tmppixel[2]; /* red */
-                        *dstpixel++=tmppixel[1]; /* green */
-                        *dstpixel++=tmppixel[0]; /* blue */
-                    }
+                    convert_row_bgrx32_to_rgb24(dstrow, srcrow, prc->Width);
                     srcrow += srcstride;
                     dstrow += cbStride;
                 }
@@ -1383,6 +1365,8 @@ static HRESULT copypixels_to_8bppGray(struct FormatConverter *This, const WICRec
     {
         INT x, y;
         BYTE *src = srcdata, *dst = pbBuffer;
+        DWORD last_color = ~0u;
+        BYTE last_gray = 0;
 
         for (y = 0; y < prc->Height; y++)
         {
@@ -1390,10 +1374,19 @@ static HRESULT copypixels_to_8bppGray(struct FormatConverter *This, const WICRec
 
             for (x = 0; x < prc->Width; x++)
             {
-                float gray = (bgr[2] * 0.2126f + bgr[1] * 0.7152f + bgr[0] * 0.0722f) / 255.0f;
+                DWORD color = bgr[0] | (bgr[1] << 8) | (bgr[2] << 16);
 
-                gray = to_sRGB_component(gray) * 255.0f;
-                dst[x] = (BYTE)floorf(gray + 0.51f);
+                /* Runs of identical pixels are common; avoid recomputing the
+                 * sRGB conversion for them. */
+                if (color != last_color)
+                {
+                    float gray = (bgr[2] * 0.2126f + bgr[1] * 0.7152f + bgr[0] * 0.0722f) / 255.0f;
+
+                    gray = to_sRGB_component(gray) * 255.0f;
+                    last_gray = (BYTE)floorf(gray + 0.51f);
+                    last_color = color;
+                }
+                dst[x] = last_gray;
                 bgr += 3;
             }
             src += srcstride;
@@ -1438,13 +1431,38 @@ static UINT rgb_to_palette_index(BYTE bgr[3], WICColor *colors, UINT count)
     return best_index;
 }
 
+/* Small direct mapped cache of nearest palette entries, so that the palette
+ * only has to be searched once for each distinct color in typical images. */
+#define PALETTE_CACHE_BITS 12
+#define PALETTE_CACHE_SIZE (1u << PALETTE_CACHE_BITS)
+
+struct palette_cache_entry
+{
+    DWORD color;
+    BYTE index;
+};
+
+static BYTE palette_cache_lookup(struct palette_cache_entry *cache, BYTE bgr[3], WICColor *colors, UINT count)
+{
+    DWORD color = bgr[0] | (bgr[1] << 8) | (bgr[2] << 16);
+    struct palette_cache_entry *entry = &cache[(color * 2654435761u) >> (32 - PALETTE_CACHE_BITS)];
+
+    if (entry->color != color)
+    {
+        entry->color = color;
+        entry->index = rgb_to_palette_index(bgr, colors, count);
+    }
+    return entry->index;
+}
+
 static HRESULT copypixels_to_8bppIndexed(struct FormatConverter *This, const WICRect *prc,
     UINT cbStride, UINT cbBufferSize, BYTE *pbBuffer, enum pixelformat source_format)
 {
+    struct palette_cache_entry *cache;
     HRESULT hr;
     BYTE *srcdata;
     WICColor colors[256];
-    UINT srcstride, srcdatasize, count;
+    UINT srcstride, srcdatasize, count, i;
 
     if (source_format == format_8bppIndexed)
     {
@@ -1468,6 +1486,15 @@ static HRESULT copypixels_to_8bppIndexed(struct FormatConverter *This, const WIC
     srcdata = HeapAlloc(GetProcessHeap(), 0, srcdatasize);
     if (!srcdata) return E_OUTOFMEMORY;
 
+    if (!(cache = HeapAlloc(GetProcessHeap(), 0, PALETTE_CACHE_SIZE * sizeof(*cache))))
+    {
+        HeapFree(GetProcessHeap(), 0, srcdata);
+        return E_OUTOFMEMORY;
+    }
+    /* Colors are 24-bit, so this never matches. */
+    for (i = 0; i < PALETTE_CACHE_SIZE; i++)
+        cache[i].color = ~0u;
+
     hr = copypixels_to_24bppBGR(This, prc, srcstride, srcdatasize, srcdata, source_format);
     if (SUCCEEDED(hr))
     {
@@ -1480,7 +1507,7 @@ static HRESULT copypixels_to_8bppIndexed(struct FormatConverter *This, const WIC
 
             for (x = 0; x < prc->Width; x++)
             {
-                dst[x] = rgb_to_palette_index(bgr, colors, count);
+                dst[x] = palette_cache_lookup(cache, bgr, colors, count);
                 bgr += 3;
             }
             src += srcstride;
@@ -1488,6 +1515,7 @@ static HRESULT copypixels_to_8bppIndexed(struct FormatConverter *This, const WIC
         }
     }
 
+    HeapFree(GetProcessHeap(), 0, cache);
     HeapFree(GetProcessHeap(), 0, srcdata);
     return hr;
 }
@@ -69,17 +69,27 @@ static void emit_message_fn(j_common_ptr cinfo, int msg_level)
     }
 }
 
+/* Decoded rows are kept in a ring buffer, so that requests for overlapping
+ * rectangles or repeated requests don't restart decompression. Frames that
+ * fit in JPEG_ROW_CACHE_SIZE are kept entirely once decoded; larger ones keep
+ * a band of the most recently decoded rows, but at least JPEG_CACHED_ROWS. */
+#define JPEG_CACHED_ROWS 16
+#define JPEG_ROW_CACHE_SIZE (64 * 1024 * 1024)
+
 struct jpeg_decoder {
     struct decoder decoder;
     struct decoder_frame frame;
     BOOL cinfo_initialized;
     IStream *stream;
+    ULONGLONG stream_pos; /* position of the data following source_buffer */
     struct jpeg_decompress_struct cinfo;
     struct jpeg_error_mgr jerr;
     struct jpeg_source_mgr source_mgr;
     BYTE source_buffer[1024];
     UINT stride;
-    BYTE *image_data;
+    BYTE *cached_rows; /* ring buffer of the last decoded rows */
+    UINT cached_row_count;
+    BOOL restart; /* decompression must start over */
 };
 
 static inline struct jpeg_decoder *impl_from_decoder(struct decoder* iface)
@@ -97,7 +107,7 @@ static void CDECL jpeg_decoder_destroy(struct decoder* iface)
     struct jpeg_decoder *This = impl_from_decoder(iface);
 
     if (This->cinfo_initialized) jpeg_destroy_decompress(&This->cinfo);
-    free(This->image_data);
+    free(This->cached_rows);
     RtlFreeHeap(GetProcessHeap(), 0, This);
 }
 
@@ -119,6 +129,7 @@ static boolean source_mgr_fill_input_buffer(j_decompress_ptr cinfo)
     }
     else
     {
+        This->stream_pos += bytesread;
         This->source_mgr.next_input_byte = This->source_buffer;
         This->source_mgr.bytes_in_buffer = bytesread;
         return TRUE;
@@ -132,6 +143,7 @@ static void source_mgr_skip_input_data(j_decompress_ptr cinfo, long num_bytes)
     if (num_bytes > This->source_mgr.bytes_in_buffer)
     {
         stream_seek(This->stream, num_bytes - This->source_mgr.bytes_in_buffer, STREAM_SEEK_CUR, NULL);
+        This->stream_pos += num_bytes - This->source_mgr.bytes_in_buffer;
         This->source_mgr.bytes_in_buffer = 0;
     }
     else if (num_bytes > 0)
@@ -145,44 +157,15 @@ static void source_mgr_term_source(j_decompress_ptr cinfo)
 {
 }
 
-static HRESULT CDECL jpeg_decoder_initialize(struct decoder* iface, IStream *stream, struct decoder_stat *st)
+/* Reads the header and prepares decompression, starting from the beginning
+ * of the stream. The caller must have set up the error handler. */
+static HRESULT jpeg_decoder_start(struct jpeg_decoder *This)
 {
-    struct jpeg_decoder *This = impl_from_decoder(iface);
     int ret;
-    jmp_buf jmpbuf;
-    UINT data_size, i;
-
-    if (This->cinfo_initialized)
-        return WINCODEC_ERR_WRONGSTATE;
-
-    jpeg_std_error(&This->jerr);
-
-    This->jerr.error_exit = error_exit_fn;
-    This->jerr.emit_message = emit_message_fn;
-
-    This->cinfo.err = &This->jerr;
-
-    This->cinfo.client_data = jmpbuf;
-
-    if (setjmp(jmpbuf))
-        return E_FAIL;
-
-    jpeg_CreateDecompress(&This->cinfo, JPEG_LIB_VERSION, sizeof(struct jpeg_decompress_struct));
-
-    This->cinfo_initialized = TRUE;
-
-    This->stream = stream;
 
     stream_seek(This->stream, 0, STREAM_SEEK_SET, NULL);
-
+    This->stream_pos = 0;
     This->source_mgr.bytes_in_buffer = 0;
-    This->source_mgr.init_source = source_mgr_init_source;
-    This->source_mgr.fill_input_buffer = source_mgr_fill_input_buffer;
-    This->source_mgr.skip_input_data = source_mgr_skip_input_data;
-    This->source_mgr.resync_to_restart = jpeg_resync_to_restart;
-    This->source_mgr.term_source = source_mgr_term_source;
-
-    This->cinfo.src = &This->source_mgr;
 
     ret = jpeg_read_header(&This->cinfo, TRUE);
 
@@ -221,6 +204,47 @@ static HRESULT CDECL jpeg_decoder_initialize(struct decoder* iface, IStream *str
         return E_FAIL;
     }
 
+    return S_OK;
+}
+
+static HRESULT CDECL jpeg_decoder_initialize(struct decoder* iface, IStream *stream, struct decoder_stat *st)
+{
+    struct jpeg_decoder *This = impl_from_decoder(iface);
+    jmp_buf jmpbuf;
+    HRESULT hr;
+
+    if (This->cinfo_initialized)
+        return WINCODEC_ERR_WRONGSTATE;
+
+    jpeg_std_error(&This->jerr);
+
+    This->jerr.error_exit = error_exit_fn;
+    This->jerr.emit_message = emit_message_fn;
+
+    This->cinfo.err = &This->jerr;
+
+    This->cinfo.client_data = jmpbuf;
+
+    if (setjmp(jmpbuf))
+        return E_FAIL;
+
+    jpeg_CreateDecompress(&This->cinfo, JPEG_LIB_VERSION, sizeof(struct jpeg_decompress_struct));
+
+    This->cinfo_initialized = TRUE;
+
+    This->stream = stream;
+
+    This->source_mgr.init_source = source_mgr_init_source;
+    This->source_mgr.fill_input_buffer = source_mgr_fill_input_buffer;
+    This->source_mgr.skip_input_data = source_mgr_skip_input_data;
+    This->source_mgr.resync_to_restart = jpeg_resync_to_restart;
+    This->source_mgr.term_source = source_mgr_term_source;
+
+    This->cinfo.src = &This->source_mgr;
+
+    if (FAILED(hr = jpeg_decoder_start(This)))
+        return hr;
+
     This->frame.width = This->cinfo.output_width;
     This->frame.height = This->cinfo.output_height;
 
@@ -245,46 +269,21 @@ static HRESULT CDECL jpeg_decoder_initialize(struct decoder* iface, IStream *str
     This->frame.num_color_contexts = 0;
     This->frame.num_colors = 0;
 
+    /* Rows are only decoded when they are requested, so that huge images
+     * don't have to be held in memory. Note that libjpeg still buffers the
+     * whole coefficient array of progressive images. */
     This->stride = (This->frame.bpp * This->cinfo.output_width + 7) / 8;
-    data_size = This->stride * This->cinfo.output_height;
-
-    This->image_data = malloc(data_size);
-    if (!This->image_data)
-        return E_OUTOFMEMORY;
-
-    while (This->cinfo.output_scanline < This->cinfo.output_height)
-    {
-        UINT first_scanline = This->cinfo.output_scanline;
-        UINT max_rows;
-        JSAMPROW out_rows[4];
-        JDIMENSION ret;
-
-        max_rows = min(This->cinfo.output_height-first_scanline, 4);
-        for (i=0; i<max_rows; i++)
-            out_rows[i] = This->image_data + This->stride * (first_scanline+i);
-
-        ret = jpeg_read_scanlines(&This->cinfo, out_rows, max_rows);
-        if (ret == 0)
-        {
-            ERR("read_scanlines failed\n");
-            return E_FAIL;
-        }
-    }
-
-    if (This->frame.bpp == 24)
-    {
-        /* libjpeg gives us RGB data and we want BGR, so byteswap the data */
-        reverse_bgr8(3, This->image_data,
-            This->cinfo.output_width, This->cinfo.output_height,
-            This->stride);
-    }
+    This->cached_row_count = min(This->cinfo.output_height,
+            max(JPEG_CACHED_ROWS, JPEG_ROW_CACHE_SIZE / This->stride));
 
-    if (This->cinfo.out_color_space == JCS_CMYK && This->cinfo.saw_Adobe_marker)
+    This->cached_rows = malloc(This->stride * This->cached_row_count);
+    if (!This->cached_rows && This->cached_row_count > JPEG_CACHED_ROWS)
     {
-        /* Adobe JPEG's have inverted CMYK data. */
-        for (i=0; i<data_size; i++)
-            This->image_data[i] ^= 0xff;
+        This->cached_row_count = min(This->cinfo.output_height, JPEG_CACHED_ROWS);
+        This->cached_rows = malloc(This->stride * This->cached_row_count);
     }
+    if (!This->cached_rows)
+        return E_OUTOFMEMORY;
 
     st->frame_count = 1;
     st->flags = WICBitmapDecoderCapabilityCanDecodeAllImages |
@@ -301,13 +300,106 @@ static HRESULT CDECL jpeg_decoder_get_frame_info(struct decoder* iface, UINT fra
     return S_OK;
 }
 
+/* Returns row y, decoding it if necessary. The caller must have set up the
+ * error handler. */
+static HRESULT jpeg_decoder_get_row(struct jpeg_decoder *This, UINT y, const BYTE **row)
+{
+    HRESULT hr;
+    UINT i;
+
+    if (This->restart || y + This->cached_row_count < This->cinfo.output_scanline)
+    {
+        TRACE("restarting decompression for row %u\n", y);
+        jpeg_abort_decompress(&This->cinfo);
+        This->restart = TRUE;
+        if (FAILED(hr = jpeg_decoder_start(This)))
+            return hr;
+        This->restart = FALSE;
+    }
+
+    while (This->cinfo.output_scanline <= y)
+    {
+        JSAMPROW out_row = This->cached_rows + This->stride * (This->cinfo.output_scanline % This->cached_row_count);
+
+        if (!jpeg_read_scanlines(&This->cinfo, &out_row, 1))
+        {
+            ERR("read_scanlines failed\n");
+            return E_FAIL;
+        }
+
+        if (This->frame.bpp == 24)
+        {
+            /* libjpeg gives us RGB data and we want BGR, so byteswap the data */
+            reverse_bgr8(3, out_row, This->cinfo.output_width, 1, This->stride);
+        }
+
+        if (This->cinfo.out_color_space == JCS_CMYK && This->cinfo.saw_Adobe_marker)
+        {
+            /* Adobe JPEG's have inverted CMYK data. */
+            for (i=0; i<This->stride; i++)
+                out_row[i] ^= 0xff;
+        }
+    }
+
+    *row = This->cached_rows + This->stride * (y % This->cached_row_count);
+    return S_OK;
+}
+
 static HRESULT CDECL jpeg_decoder_copy_pixels(struct decoder* iface, UINT frame,
     const WICRect *prc, UINT stride, UINT buffersize, BYTE *buffer)
 {
     struct jpeg_decoder *This = impl_from_decoder(iface);
-    return copy_pixels(This->frame.bpp, This->image_data,
-        This->frame.width, This->frame.height, This->stride,
-        prc, stride, buffersize, buffer);
+    UINT bytesperpixel = This->frame.bpp / 8, bytesperrow, y;
+    const BYTE *row;
+    jmp_buf jmpbuf;
+    WICRect rect;
+    HRESULT hr;
+
+    if (!prc)
+    {
+        rect.X = 0;
+        rect.Y = 0;
+        rect.Width = This->frame.width;
+        rect.Height = This->frame.height;
+        prc = &rect;
+    }
+    else
+    {
+        if (prc->X < 0 || prc->Y < 0 || prc->X+prc->Width > This->frame.width ||
+                prc->Y+prc->Height > This->frame.height)
+            return E_INVALIDARG;
+    }
+
+    bytesperrow = bytesperpixel * prc->Width;
+
+    if (stride < bytesperrow)
+        return E_INVALIDARG;
+
+    if ((stride * (prc->Height-1)) + bytesperrow > buffersize)
+        return E_INVALIDARG;
+
+    This->cinfo.client_data = jmpbuf;
+
+    if (setjmp(jmpbuf))
+    {
+        This->restart = TRUE;
+        return E_FAIL;
+    }
+
+    /* Somebody else may have used the stream since the last call. */
+    stream_seek(This->stream, This->stream_pos, STREAM_SEEK_SET, NULL);
+
+    for (y = 0; y < prc->Height; y++)
+    {
+        if (FAILED(hr = jpeg_decoder_get_row(This, prc->Y + y, &row)))
+        {
+            This->restart = TRUE;
+            return hr;
+        }
+        memcpy(buffer + stride * y, row + bytesperpixel * prc->X, bytesperrow);
+    }
+
+    return S_OK;
 }
 
 static HRESULT CDECL jpeg_decoder_get_metadata_blocks(struct decoder* iface, UINT frame,
@@ -346,7 +438,8 @@ HRESULT CDECL jpeg_decoder_create(struct decoder_info *info, struct decoder **re
     This->decoder.vtable = &jpeg_decoder_vtable;
     This->cinfo_initialized = FALSE;
     This->stream = NULL;
-    This->image_data = NULL;
+    This->cached_rows = NULL;
+    This->restart = FALSE;
     *result = &This->decoder;
 
     info->container_format = GUID_ContainerFormatJpeg;
@@ -18,6 +18,7 @@
  */
 
 #include <stdarg.h>
+#include <math.h>
 
 #define COBJMACROS
 
@@ -31,6 +32,18 @@
 
 WINE_DEFAULT_DEBUG_CHANNEL(wincodecs);
 
+/* Filter weights are fixed point numbers with this many fractional bits. */
+#define FILTER_WEIGHT_BITS 14
+
+/* Precomputed filter taps for one axis. Each destination pixel uses "taps"
+ * consecutive source pixels, starting at start[i]. */
+struct scaler_filter
+{
+    UINT taps;
+    UINT *start;
+    INT *weights;
+};
+
 typedef struct BitmapScaler {
     IWICBitmapScaler IWICBitmapScaler_iface;
     LONG ref;
@@ -42,6 +55,10 @@ typedef struct BitmapScaler {
     UINT bpp;
     void (*fn_get_required_source_rect)(struct BitmapScaler*,UINT,UINT,WICRect*);
     void (*fn_copy_scanline)(struct BitmapScaler*,UINT,UINT,UINT,BYTE**,UINT,UINT,BYTE*);
+    struct scaler_filter x_filter, y_filter;
+    INT *row_buffer;
+    BYTE *cache_bits; /* source row buffer, kept to avoid reallocating it for each scanline */
+    UINT cache_size;
     CRITICAL_SECTION lock; /* must be held when initialized */
 } BitmapScaler;
 
@@ -94,6 +111,13 @@ static ULONG WINAPI BitmapScaler_AddRef(IWICBitmapScaler *iface)
     return ref;
 }
 
+static void free_filter(struct scaler_filter *filter)
+{
+    HeapFree(GetProcessHeap(), 0, filter->start);
+    HeapFree(GetProcessHeap(), 0, filter->weights);
+    memset(filter, 0, sizeof(*filter));
+}
+
 static ULONG WINAPI BitmapScaler_Release(IWICBitmapScaler *iface)
 {
     BitmapScaler *This = impl_from_IWICBitmapScaler(iface);
@@ -106,6 +130,10 @@ static ULONG WINAPI BitmapScaler_Release(IWICBitmapScaler *iface)
         This->lock.DebugInfo->Spare[0] = 0;
         DeleteCriticalSection(&This->lock);
         if (This->source) IWICBitmapSource_Release(This->source);
+        free_filter(&This->x_filter);
+        free_filter(&This->y_filter);
+        HeapFree(GetProcessHeap(), 0, This->row_buffer);
+        HeapFree(GetProcessHeap(), 0, This->cache_bits);
         HeapFree(GetProcessHeap(), 0, This);
     }
 
@@ -203,6 +231,206 @@ static void NearestNeighbor_CopyScanline(BitmapScaler *This,
     }
 }
 
+static double cubic_weight(double x)
+{
+    /* Catmull-Rom spline. */
+    x = fabs(x);
+    if (x < 1.0)
+        return (1.5 * x - 2.5) * x * x + 1.0;
+    if (x < 2.0)
+        return ((-0.5 * x + 2.5) * x - 4.0) * x + 2.0;
+    return 0.0;
+}
+
+static double filter_weight(WICBitmapInterpolationMode mode, double x, double filter_scale)
+{
+    double r;
+
+    switch (mode)
+    {
+    case WICBitmapInterpolationModeLinear:
+        return max(1.0 - fabs(x), 0.0);
+    case WICBitmapInterpolationModeCubic:
+        return cubic_weight(x);
+    case WICBitmapInterpolationModeHighQualityCubic:
+        return cubic_weight(x / filter_scale);
+    case WICBitmapInterpolationModeFant:
+    default:
+        /* Coverage of the source pixel by the destination pixel. */
+        r = filter_scale / 2.0;
+        return max(min(x + 0.5, r) - max(x - 0.5, -r), 0.0);
+    }
+}
+
+static HRESULT init_filter(struct scaler_filter *filter, WICBitmapInterpolationMode mode,
+    UINT src_size, UINT dst_size)
+{
+    double scale = (double)src_size / dst_size, filter_scale = 1.0, radius, center, *weights;
+    UINT i, j, best, support;
+    INT first, start, sum;
+
+    /* Fant and high quality cubic widen the filter when downscaling, so that
+     * every source pixel contributes. Linear and cubic sample the source
+     * like the native implementation does. */
+    if ((mode == WICBitmapInterpolationModeFant || mode == WICBitmapInterpolationModeHighQualityCubic)
+            && scale > 1.0)
+        filter_scale = scale;
+
+    switch (mode)
+    {
+    case WICBitmapInterpolationModeLinear: radius = 1.0; break;
+    case WICBitmapInterpolationModeCubic: radius = 2.0; break;
+    case WICBitmapInterpolationModeHighQualityCubic: radius = 2.0 * filter_scale; break;
+    default: radius = filter_scale / 2.0 + 0.5; break;
+    }
+
+    support = ceil(2.0 * radius);
+    filter->taps = min(src_size, support);
+
+    filter->start = HeapAlloc(GetProcessHeap(), 0, dst_size * sizeof(*filter->start));
+    filter->weights = HeapAlloc(GetProcessHeap(), 0, dst_size * filter->taps * sizeof(*filter->weights));
+    weights = HeapAlloc(GetProcessHeap(), 0, filter->taps * sizeof(*weights));
+    if (!filter->start || !filter->weights || !weights)
+    {
+        HeapFree(GetProcessHeap(), 0, weights);
+        free_filter(filter);
+        return E_OUTOFMEMORY;
+    }
+
+    for (i = 0; i < dst_size; i++)
+    {
+        double total = 0.0;
+        INT *w = filter->weights + i * filter->taps;
+
+        center = (i + 0.5) * scale - 0.5;
+        first = (INT)floor(center - radius) + 1;
+        start = max(min(first, (INT)(src_size - filter->taps)), 0);
+        filter->start[i] = start;
+
+        /* Source pixels outside the image are replaced by the edge pixels. */
+        memset(weights, 0, filter->taps * sizeof(*weights));
+        for (j = 0; j < support; j++)
+        {
+            INT x = max(min(first + (INT)j, (INT)src_size - 1), 0);
+            double weight = filter_weight(mode, first + (INT)j - center, filter_scale);
+
+            weights[x - start] += weight;
+            total += weight;
+        }
+
+        sum = 0;
+        best = 0;
+        for (j = 0; j < filter->taps; j++)
+        {
+            w[j] = total > 0.0 ? floor(weights[j] / total * (1 << FILTER_WEIGHT_BITS) + 0.5) : 0;
+            sum += w[j];
+            if (weights[j] > weights[best]) best = j;
+        }
+        /* Make sure that the weights add up to exactly one. */
+        w[best] += (1 << FILTER_WEIGHT_BITS) - sum;
+    }
+
+    HeapFree(GetProcessHeap(), 0, weights);
+    return S_OK;
+}
+
+static void Filter_GetRequiredSourceRect(BitmapScaler *This,
+    UINT x, UINT y, WICRect *src_rect)
+{
+    src_rect->X = This->x_filter.start[x];
+    src_rect->Y = This->y_filter.start[y];
+    src_rect->Width = This->x_filter.taps;
+    src_rect->Height = This->y_filter.taps;
+}
+
+static void Filter_CopyScanline(BitmapScaler *This,
+    UINT dst_x, UINT dst_y, UINT dst_width,
+    BYTE **src_data, UINT src_data_x, UINT src_data_y, BYTE *pbBuffer)
+{
+    const struct scaler_filter *x_filter = &This->x_filter, *y_filter = &This->y_filter;
+    UINT channels = This->bpp / 8;
+    UINT first_x = x_filter->start[dst_x];
+    UINT count = (x_filter->start[dst_x + dst_width - 1] + x_filter->taps - first_x) * channels;
+    const INT *weights = y_filter->weights + dst_y * y_filter->taps;
+    INT *row = This->row_buffer;
+    UINT i, k, c;
+
+    /* Filter vertically first, over all the source columns that are needed,
+     * keeping 6 extra bits of precision. The inner loops are simple enough
+     * for the compiler to vectorize. */
+    memset(row, 0, count * sizeof(*row));
+    for (k = 0; k < y_filter->taps; k++)
+    {
+        const BYTE *src = src_data[y_filter->start[dst_y] + k - src_data_y] + (first_x - src_data_x) * channels;
+        INT weight = weights[k];
+
+        if (!weight) continue;
+        for (i = 0; i < count; i++)
+            row[i] += weight * src[i];
+    }
+    for (i = 0; i < count; i++)
+        row[i] = (row[i] + (1 << 7)) >> 8;
+
+    for (i = 0; i < dst_width; i++)
+    {
+        const INT *src = row + (x_filter->start[dst_x + i] - first_x) * channels;
+
+        weights = x_filter->weights + (dst_x + i) * x_filter->taps;
+        for (c = 0; c < channels; c++)
+        {
+            INT sum = 1 << (FILTER_WEIGHT_BITS * 2 - 8 - 1);
+
+            for (k = 0; k < x_filter->taps; k++)
+                sum += weights[k] * src[k * channels + c];
+            sum >>= FILTER_WEIGHT_BITS * 2 - 8;
+            pbBuffer[i * channels + c] = sum < 0 ? 0 : (sum > 255 ? 255 : sum);
+        }
+    }
+}
+
+static BOOL format_supports_filtering(const WICPixelFormatGUID *format)
+{
+    static const WICPixelFormatGUID *formats[] =
+    {
+        &GUID_WICPixelFormat8bppGray,
+        &GUID_WICPixelFormat24bppBGR,
+        &GUID_WICPixelFormat24bppRGB,
+        &GUID_WICPixelFormat32bppBGR,
+        &GUID_WICPixelFormat32bppBGRA,
+        &GUID_WICPixelFormat32bppPBGRA,
+        &GUID_WICPixelFormat32bppRGB,
+        &GUID_WICPixelFormat32bppRGBA,
+        &GUID_WICPixelFormat32bppPRGBA,
+    };
+    unsigned int i;
+
+    for (i = 0; i < ARRAY_SIZE(formats); i++)
+        if (IsEqualGUID(format, formats[i])) return TRUE;
+    return FALSE;
+}
+
+/* Read the source rows for src_rect into the row buffer. */
+static HRESULT read_source_rows(BitmapScaler *This, const WICRect *src_rect, UINT stride)
+{
+    UINT size = stride * src_rect->Height;
+
+    if (size > This->cache_size)
+    {
+        BYTE *bits;
+
+        if (This->cache_bits)
+            bits = HeapReAlloc(GetProcessHeap(), 0, This->cache_bits, size);
+        else
+            bits = HeapAlloc(GetProcessHeap(), 0, size);
+        if (!bits)
+            return E_OUTOFMEMORY;
+        This->cache_bits = bits;
+        This->cache_size = size;
+    }
+
+    return IWICBitmapSource_CopyPixels(This->source, src_rect, stride, size, This->cache_bits);
+}
+
 static HRESULT WINAPI BitmapScaler_CopyPixels(IWICBitmapScaler *iface,
     const WICRect *prc, UINT cbStride, UINT cbBufferSize, BYTE *pbBuffer)
 {
@@ -211,10 +439,8 @@ static HRESULT WINAPI BitmapScaler_CopyPixels(IWICBitmapScaler *iface,
     WICRect dest_rect;
     WICRect src_rect_ul, src_rect_br, src_rect;
     BYTE **src_rows;
-    BYTE *src_bits;
     ULONG bytesperrow;
     ULONG src_bytesperrow;
-    ULONG buffer_size;
     UINT y;
 
     TRACE("(%p,%s,%u,%u,%p)\n", iface, debug_wic_rect(prc), cbStride, cbBufferSize, pbBuffer);
@@ -258,12 +484,9 @@ static HRESULT WINAPI BitmapScaler_CopyPixels(IWICBitmapScaler *iface,
     }
 
     /* MSDN recommends calling CopyPixels once for each scanline from top to
-     * bottom, and claims codecs optimize for this. Ideally, when called in this
-     * way, we should avoid requesting a scanline from the source more than
-     * once, by saving the data that will be useful for the next scanline after
-     * the call returns. The GetRequiredSourceRect/CopyScanline functions are
-     * designed to make it possible to do this in a generic way, but for now we
-     * just grab all the data we need in each call. */
+     * bottom, and claims codecs optimize for this. Source rows are not kept
+     * after the call returns, since the source may change between calls; all
+     * the data needed is read again in each call. */
 
     This->fn_get_required_source_rect(This, dest_rect.X, dest_rect.Y, &src_rect_ul);
     This->fn_get_required_source_rect(This, dest_rect.X+dest_rect.Width-1,
@@ -275,27 +498,21 @@ static HRESULT WINAPI BitmapScaler_CopyPixels(IWICBitmapScaler *iface,
     src_rect.Height = src_rect_br.Height + src_rect_br.Y - src_rect_ul.Y;
 
     src_bytesperrow = (src_rect.Width * This->bpp + 7)/8;
-    buffer_size = src_bytesperrow * src_rect.Height;
 
     src_rows = HeapAlloc(GetProcessHeap(), 0, sizeof(BYTE*) * src_rect.Height);
-    src_bits = HeapAlloc(GetProcessHeap(), 0, buffer_size);
-
-    if (!src_rows || !src_bits)
+    if (!src_rows)
     {
-        HeapFree(GetProcessHeap(), 0, src_rows);
-        HeapFree(GetProcessHeap(), 0, src_bits);
         hr = E_OUTOFMEMORY;
         goto end;
     }
 
-    for (y=0; y<src_rect.Height; y++)
-        src_rows[y] = src_bits + y * src_bytesperrow;
-
-    hr = IWICBitmapSource_CopyPixels(This->source, &src_rect, src_bytesperrow,
-        buffer_size, src_bits);
+    hr = read_source_rows(This, &src_rect, src_bytesperrow);
 
     if (SUCCEEDED(hr))
     {
+        for (y=0; y<src_rect.Height; y++)
+            src_rows[y] = This->cache_bits + y * src_bytesperrow;
+
         for (y=0; y < dest_rect.Height; y++)
         {
             This->fn_copy_scanline(This, dest_rect.X, dest_rect.Y+y, dest_rect.Width,
@@ -304,7 +521,14 @@ static HRESULT WINAPI BitmapScaler_CopyPixels(IWICBitmapScaler *iface,
     }
 
     HeapFree(GetProcessHeap(), 0, src_rows);
-    HeapFree(GetProcessHeap(), 0, src_bits);
+
+    /* Release the row buffer once the bottom of the image has been read. */
+    if (FAILED(hr) || dest_rect.Y + dest_rect.Height == This->height)
+    {
+        HeapFree(GetProcessHeap(), 0, This->cache_bits);
+        This->cache_bits = NULL;
+        This->cache_size = 0;
+    }
 
 end:
     LeaveCriticalSection(&This->lock);
@@ -347,10 +571,38 @@ static HRESULT WINAPI BitmapScaler_Initialize(IWICBitmapScaler *iface,
         hr = get_pixelformat_bpp(&src_pixelformat, &This->bpp);
     }
 
+    if (SUCCEEDED(hr) && mode != WICBitmapInterpolationModeNearestNeighbor
+            && !format_supports_filtering(&src_pixelformat))
+    {
+        FIXME("unsupported pixel format %s for mode %i\n", debugstr_guid(&src_pixelformat), mode);
+        mode = WICBitmapInterpolationModeNearestNeighbor;
+    }
+
     if (SUCCEEDED(hr))
     {
         switch (mode)
         {
+        case WICBitmapInterpolationModeLinear:
+        case WICBitmapInterpolationModeCubic:
+        case WICBitmapInterpolationModeFant:
+        case WICBitmapInterpolationModeHighQualityCubic:
+            hr = init_filter(&This->x_filter, mode, This->src_width, This->width);
+            if (SUCCEEDED(hr))
+                hr = init_filter(&This->y_filter, mode, This->src_height, This->height);
+            if (SUCCEEDED(hr) && !(This->row_buffer = HeapAlloc(GetProcessHeap(), 0,
+                    This->src_width * (This->bpp / 8) * sizeof(*This->row_buffer))))
+                hr = E_OUTOFMEMORY;
+            if (FAILED(hr))
+            {
+                free_filter(&This->x_filter);
+                free_filter(&This->y_filter);
+                break;
+            }
+            IWICBitmapSource_AddRef(pISource);
+            This->source = pISource;
+            This->fn_get_required_source_rect = Filter_GetRequiredSourceRect;
+            This->fn_copy_scanline = Filter_CopyScanline;
+            break;
         default:
             FIXME("unsupported mode %i\n", mode);
             /* fall-through */
@@ -527,6 +779,11 @@ HRESULT BitmapScaler_Create(IWICBitmapScaler **scaler)
     This->src_height = 0;
     This->mode = 0;
     This->bpp = 0;
+    memset(&This->x_filter, 0, sizeof(This->x_filter));
+    memset(&This->y_filter, 0, sizeof(This->y_filter));
+    This->row_buffer = NULL;
+    This->cache_bits = NULL;
+    This->cache_size = 0;
     InitializeCriticalSection(&This->lock);
     This->lock.DebugInfo->Spare[0] = (DWORD_PTR)(__FILE__ ": BitmapScaler.lock");
 
@@ -1312,6 +1312,159 @@ static void test_bitmap_scaler(void)
     IWICBitmap_Release(bitmap);
 }
 
+static void test_bitmap_scaler_interpolation(void)
+{
+    static const BYTE checker[] =
+    {
+        0x00,0x00,0x00,0xff, 0xff,0xff,0xff,0xff,
+        0xff,0xff,0xff,0xff, 0x00,0x00,0x00,0xff,
+    };
+    static const BYTE uniform[] =
+    {
+        0x10,0x80,0xf0,0xff, 0x10,0x80,0xf0,0xff,
+        0x10,0x80,0xf0,0xff, 0x10,0x80,0xf0,0xff,
+    };
+    static const WICBitmapInterpolationMode modes[] =
+    {
+        WICBitmapInterpolationModeLinear,
+        WICBitmapInterpolationModeCubic,
+        WICBitmapInterpolationModeFant,
+        WICBitmapInterpolationModeHighQualityCubic,
+    };
+    IWICBitmapScaler *scaler;
+    IWICBitmap *bitmap;
+    BYTE buf[5 * 3 * 4];
+    unsigned int i, j;
+    HRESULT hr;
+
+    for (i = 0; i < ARRAY_SIZE(modes); i++)
+    {
+        hr = IWICImagingFactory_CreateBitmapFromMemory(factory, 2, 2, &GUID_WICPixelFormat32bppBGRA,
+            8, sizeof(checker), (BYTE *)checker, &bitmap);
+        ok(hr == S_OK, "Failed to create a bitmap, hr %#x.\n", hr);
+
+        hr = IWICImagingFactory_CreateBitmapScaler(factory, &scaler);
+        ok(hr == S_OK, "Failed to create bitmap scaler, hr %#x.\n", hr);
+
+        hr = IWICBitmapScaler_Initialize(scaler, (IWICBitmapSource *)bitmap, 1, 1, modes[i]);
+        if (hr != S_OK && modes[i] == WICBitmapInterpolationModeHighQualityCubic)
+        {
+            win_skip("High quality cubic interpolation is not supported.\n");
+            IWICBitmapScaler_Release(scaler);
+            IWICBitmap_Release(bitmap);
+            continue;
+        }
+        ok(hr == S_OK, "Mode %u: failed to initialize bitmap scaler, hr %#x.\n", modes[i], hr);
+
+        /* Every mode should average a symmetric pattern. */
+        memset(buf, 0xcc, sizeof(buf));
+        hr = IWICBitmapScaler_CopyPixels(scaler, NULL, 4, 4, buf);
+        ok(hr == S_OK, "Mode %u: failed to copy pixels, hr %#x.\n", modes[i], hr);
+        for (j = 0; j < 3; j++)
+            ok(buf[j] >= 0x7f && buf[j] <= 0x80, "Mode %u: got unexpected value %#x for channel %u.\n",
+                modes[i], buf[j], j);
+        ok(buf[3] == 0xff, "Mode %u: got unexpected alpha %#x.\n", modes[i], buf[3]);
+
+        IWICBitmapScaler_Release(scaler);
+        IWICBitmap_Release(bitmap);
+
+        hr = IWICImagingFactory_CreateBitmapFromMemory(factory, 2, 2, &GUID_WICPixelFormat32bppBGRA,
+            8, sizeof(uniform), (BYTE *)uniform, &bitmap);
+        ok(hr == S_OK, "Failed to create a bitmap, hr %#x.\n", hr);
+
+        hr = IWICImagingFactory_CreateBitmapScaler(factory, &scaler);
+        ok(hr == S_OK, "Failed to create bitmap scaler, hr %#x.\n", hr);
+
+        hr = IWICBitmapScaler_Initialize(scaler, (IWICBitmapSource *)bitmap, 5, 3, modes[i]);
+        ok(hr == S_OK, "Mode %u: failed to initialize bitmap scaler, hr %#x.\n", modes[i], hr);
+
+        /* Scanline by scanline, as recommended by MSDN. */
+        memset(buf, 0xcc, sizeof(buf));
+        for (j = 0; j < 3; j++)
+        {
+            WICRect rc = {0, j, 5, 1};
+
+            hr = IWICBitmapScaler_CopyPixels(scaler, &rc, 20, 20, buf + j * 20);
+            ok(hr == S_OK, "Mode %u: failed to copy pixels, hr %#x.\n", modes[i], hr);
+        }
+        for (j = 0; j < sizeof(buf); j++)
+            ok(abs(buf[j] - uniform[j % 4]) <= 1, "Mode %u: got unexpected value %#x at %u.\n",
+                modes[i], buf[j], j);
+
+        IWICBitmapScaler_Release(scaler);
+        IWICBitmap_Release(bitmap);
+    }
+}
+
+static void fill_bitmap(IWICBitmap *bitmap, DWORD color)
+{
+    IWICBitmapLock *lock;
+    UINT size, i;
+    DWORD *data;
+    HRESULT hr;
+
+    hr = IWICBitmap_Lock(bitmap, NULL, WICBitmapLockWrite, &lock);
+    ok(hr == S_OK, "Failed to lock bitmap, hr %#x.\n", hr);
+    hr = IWICBitmapLock_GetDataPointer(lock, &size, (BYTE **)&data);
+    ok(hr == S_OK, "Failed to get data pointer, hr %#x.\n", hr);
+    for (i = 0; i < size / sizeof(*data); i++)
+        data[i] = color;
+    IWICBitmapLock_Release(lock);
+}
+
+static BOOL color_match(DWORD c1, DWORD c2)
+{
+    unsigned int i;
+
+    for (i = 0; i < 32; i += 8)
+        if (abs((int)((c1 >> i) & 0xff) - (int)((c2 >> i) & 0xff)) > 1) return FALSE;
+    return TRUE;
+}
+
+static void test_bitmap_scaler_source_change(void)
+{
+    IWICBitmapScaler *scaler;
+    IWICBitmap *bitmap;
+    DWORD buf[2 * 4];
+    WICRect rc;
+    unsigned int i;
+    HRESULT hr;
+
+    hr = IWICImagingFactory_CreateBitmap(factory, 2, 4, &GUID_WICPixelFormat32bppBGRA,
+        WICBitmapCacheOnLoad, &bitmap);
+    ok(hr == S_OK, "Failed to create a bitmap, hr %#x.\n", hr);
+    fill_bitmap(bitmap, 0xff102030);
+
+    hr = IWICImagingFactory_CreateBitmapScaler(factory, &scaler);
+    ok(hr == S_OK, "Failed to create bitmap scaler, hr %#x.\n", hr);
+    hr = IWICBitmapScaler_Initialize(scaler, (IWICBitmapSource *)bitmap, 2, 8, WICBitmapInterpolationModeLinear);
+    ok(hr == S_OK, "Failed to initialize bitmap scaler, hr %#x.\n", hr);
+
+    rc.X = 0;
+    rc.Y = 0;
+    rc.Width = 2;
+    rc.Height = 4;
+    memset(buf, 0xcc, sizeof(buf));
+    hr = IWICBitmapScaler_CopyPixels(scaler, &rc, 8, sizeof(buf), (BYTE *)buf);
+    ok(hr == S_OK, "Failed to copy pixels, hr %#x.\n", hr);
+    for (i = 0; i < ARRAY_SIZE(buf); i++)
+        ok(color_match(buf[i], 0xff102030), "Got unexpected value %#x at %u.\n", buf[i], i);
+
+    /* The next band must see the new contents, including the source rows
+     * which were also needed by the previous band. */
+    fill_bitmap(bitmap, 0xff605040);
+
+    rc.Y = 4;
+    memset(buf, 0xcc, sizeof(buf));
+    hr = IWICBitmapScaler_CopyPixels(scaler, &rc, 8, sizeof(buf), (BYTE *)buf);
+    ok(hr == S_OK, "Failed to copy pixels, hr %#x.\n", hr);
+    for (i = 0; i < ARRAY_SIZE(buf); i++)
+        ok(color_match(buf[i], 0xff605040), "Got unexpected value %#x at %u.\n", buf[i], i);
+
+    IWICBitmapScaler_Release(scaler);
+    IWICBitmap_Release(bitmap);
+}
+
 static LONG obj_refcount(void *obj)
 {
     IUnknown_AddRef((IUnknown *)obj);
@@ -1482,6 +1635,8 @@ START_TEST(bitmap)
     test_CreateBitmapFromHBITMAP();
     test_clipper();
     test_bitmap_scaler();
+    test_bitmap_scaler_interpolation();
+    test_bitmap_scaler_source_change();
 
     IWICImagingFactory_Release(factory);
 
@@ -2289,6 +2289,12 @@ HRESULT wined3d_context_gl_init(struct wined3d_context_gl *context_gl, struct wi
     }
     if (gl_info->supported[ARB_CLIP_CONTROL])
         GL_EXTCALL(glPointParameteri(GL_POINT_SPRITE_COORD_ORIGIN, GL_LOWER_LEFT));
+    if (wined3d_settings.async_shader_compile && gl_info->supported[ARB_PARALLEL_SHADER_COMPILE])
+    {
+        /* Let the driver pick the number of compiler threads. */
+        GL_EXTCALL(glMaxShaderCompilerThreadsARB(~0u));
+        checkGLcall("glMaxShaderCompilerThreadsARB");
+    }
 
     /* If this happens to be the first context for the device, dummy textures
      * are not created yet. In that case, they will be created (and bound) by
@@ -4004,6 +4010,10 @@ static BOOL context_apply_draw_state(struct wined3d_context *context,
     if (context->shader_update_mask & ~(1u << WINED3D_SHADER_TYPE_COMPUTE))
     {
         device->shader_backend->shader_select(device->shader_priv, context, state);
+        /* Leave the update mask alone, so that we select again on the next
+         * draw, and hopefully find the program ready by then. */
+        if (context->shader_program_pending)
+            return FALSE;
         context->shader_update_mask &= 1u << WINED3D_SHADER_TYPE_COMPUTE;
     }
 
@@ -4879,8 +4889,11 @@ void draw_primitive(struct wined3d_device *device, const struct wined3d_state *s
 
     if (!context_apply_draw_state(context, device, state, parameters->indexed))
     {
+        if (context->shader_program_pending)
+            TRACE("Shader program is not ready yet, skipping draw.\n");
+        else
+            WARN("Unable to apply draw state, skipping draw.\n");
         context_release(context);
-        WARN("Unable to apply draw state, skipping draw.\n");
         return;
     }
 
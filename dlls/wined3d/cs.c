@@ -21,10 +21,18 @@
 #include "wined3d_private.h"
 
 WINE_DEFAULT_DEBUG_CHANNEL(d3d);
+WINE_DECLARE_DEBUG_CHANNEL(d3d_perf);
 WINE_DECLARE_DEBUG_CHANNEL(d3d_sync);
 WINE_DECLARE_DEBUG_CHANNEL(fps);
 
 #define WINED3D_INITIAL_CS_SIZE 4096
+#define WINED3D_DEFERRED_RESOURCE_LOOKBACK 32
+
+struct wined3d_deferred_resource
+{
+    struct wined3d_resource *resource;
+    unsigned int acquire_count;
+};
 
 struct wined3d_deferred_upload
 {
@@ -51,7 +59,7 @@ struct wined3d_command_list
     void *data;
 
     SIZE_T resource_count;
-    struct wined3d_resource **resources;
+    struct wined3d_deferred_resource *resources;
 
     SIZE_T upload_count;
     struct wined3d_deferred_upload *uploads;
@@ -76,6 +84,7 @@ static void wined3d_command_list_destroy_object(void *object)
     for (i = 0; i < list->upload_count; ++i)
         heap_free(list->uploads[i].sysmem);
 
+    heap_free(list->data);
     heap_free(list);
 }
 
@@ -102,7 +111,7 @@ ULONG CDECL wined3d_command_list_decref(struct wined3d_command_list *list)
         for (i = 0; i < list->command_list_count; ++i)
             wined3d_command_list_decref(list->command_lists[i]);
         for (i = 0; i < list->resource_count; ++i)
-            wined3d_resource_decref(list->resources[i]);
+            wined3d_resource_decref(list->resources[i].resource);
         for (i = 0; i < list->upload_count; ++i)
             wined3d_resource_decref(list->uploads[i].resource);
         for (i = 0; i < list->query_count; ++i)
@@ -658,6 +667,53 @@ static void wined3d_cs_exec_nop(struct wined3d_cs *cs, const void *data)
 {
 }
 
+/* Keep a uniform random sample of the frame times in the current window, so
+ * that the percentiles cover the whole window at high frame rates. */
+static void wined3d_swapchain_add_frame_time(struct wined3d_swapchain *swapchain, float time)
+{
+    unsigned int i;
+
+    if (!swapchain->frame_times && !(swapchain->frame_times
+            = heap_alloc(WINED3D_FRAME_TIME_SAMPLES * sizeof(*swapchain->frame_times))))
+        return;
+
+    swapchain->frame_time_max = max(swapchain->frame_time_max, time);
+    i = swapchain->frame_time_count++;
+    if (i >= WINED3D_FRAME_TIME_SAMPLES)
+    {
+        swapchain->frame_time_seed = swapchain->frame_time_seed * 1664525u + 1013904223u;
+        if ((i = ((UINT64)swapchain->frame_time_seed * swapchain->frame_time_count) >> 32)
+                >= WINED3D_FRAME_TIME_SAMPLES)
+            return;
+    }
+    swapchain->frame_times[i] = time;
+}
+
+static void wined3d_swapchain_trace_frame_times(struct wined3d_swapchain *swapchain)
+{
+    float *times = swapchain->frame_times;
+    unsigned int count, i, j;
+    float t;
+
+    if (!(count = min(swapchain->frame_time_count, WINED3D_FRAME_TIME_SAMPLES)))
+        return;
+
+    /* Insertion sort; there are only a few hundred samples at most. */
+    for (i = 1; i < count; ++i)
+    {
+        t = times[i];
+        for (j = i; j && times[j - 1] > t; --j)
+            times[j] = times[j - 1];
+        times[j] = t;
+    }
+
+    TRACE_(fps)("%p frame times (%u frames): 50%% %.2fms, 95%% %.2fms, 99%% %.2fms, max %.2fms\n",
+            swapchain, swapchain->frame_time_count, times[count * 50 / 100], times[count * 95 / 100],
+            times[count * 99 / 100], swapchain->frame_time_max);
+    swapchain->frame_time_count = 0;
+    swapchain->frame_time_max = 0.0f;
+}
+
 static void wined3d_cs_exec_present(struct wined3d_cs *cs, const void *data)
 {
     struct wined3d_texture *logo_texture, *cursor_texture, *back_buffer;
@@ -724,13 +780,23 @@ static void wined3d_cs_exec_present(struct wined3d_cs *cs, const void *data)
     if (TRACE_ON(fps))
     {
         DWORD time = GetTickCount();
+        LARGE_INTEGER counter, freq;
+
         ++swapchain->frames;
 
+        QueryPerformanceCounter(&counter);
+        QueryPerformanceFrequency(&freq);
+        if (swapchain->last_present_time)
+            wined3d_swapchain_add_frame_time(swapchain,
+                    (counter.QuadPart - swapchain->last_present_time) * 1000.0 / freq.QuadPart);
+        swapchain->last_present_time = counter.QuadPart;
+
         /* every 1.5 seconds */
         if (time - swapchain->prev_time > 1500)
         {
             TRACE_(fps)("%p @ approx %.2ffps\n",
                     swapchain, 1000.0 * swapchain->frames / (time - swapchain->prev_time));
+            wined3d_swapchain_trace_frame_times(swapchain);
             swapchain->prev_time = time;
             swapchain->frames = 0;
         }
@@ -2413,7 +2479,7 @@ static void wined3d_cs_acquire_command_list(struct wined3d_device_context *conte
     }
 
     for (i = 0; i < list->resource_count; ++i)
-        wined3d_resource_acquire(list->resources[i]);
+        wined3d_resource_acquire_count(list->resources[i].resource, list->resources[i].acquire_count);
 
     for (i = 0; i < list->command_list_count; ++i)
         wined3d_cs_acquire_command_list(context, list->command_lists[i]);
@@ -2777,6 +2843,9 @@ static void wined3d_cs_exec_update_sub_resource(struct wined3d_cs *cs, const voi
 done:
     context_release(context);
 
+    if (op->bo.flags & UPLOAD_BO_UPLOAD_RING)
+        InterlockedExchange(&cs->upload_ring.tail, op->bo.ring_end);
+
     wined3d_resource_release(resource);
 }
 
@@ -3114,9 +3183,101 @@ static void wined3d_cs_st_finish(struct wined3d_device_context *context, enum wi
 {
 }
 
+static void *wined3d_cs_upload_ring_alloc(struct wined3d_cs *cs, size_t size, ULONG *end)
+{
+    struct wined3d_cs_upload_ring *ring = &cs->upload_ring;
+    ULONG head = ring->head, offset, pad;
+    BYTE *base;
+
+    size = align(size, RESOURCE_ALIGNMENT);
+    if (size > WINED3D_CS_UPLOAD_RING_SIZE / 4)
+        return NULL;
+
+    if (!ring->data && !(ring->data = heap_alloc(WINED3D_CS_UPLOAD_RING_SIZE + RESOURCE_ALIGNMENT - 1)))
+        return NULL;
+    base = (BYTE *)align((size_t)ring->data, RESOURCE_ALIGNMENT);
+
+    /* Allocations are contiguous; skip the end of the ring if needed. */
+    offset = head & (WINED3D_CS_UPLOAD_RING_SIZE - 1);
+    pad = offset + size > WINED3D_CS_UPLOAD_RING_SIZE ? WINED3D_CS_UPLOAD_RING_SIZE - offset : 0;
+    if (head + pad + size - (ULONG)*(volatile LONG *)&ring->tail > WINED3D_CS_UPLOAD_RING_SIZE)
+    {
+        TRACE("Upload ring is full.\n");
+        return NULL;
+    }
+
+    ring->head = head + pad + size;
+    *end = ring->head;
+    return base + ((head + pad) & (WINED3D_CS_UPLOAD_RING_SIZE - 1));
+}
+
+/* The ring hands out uninitialised memory, and the whole mapped box is
+ * uploaded on unmap, so it can only be used when every byte of the box is
+ * going to be written. That's the case for DISCARD maps and for
+ * update_sub_resource(), but not for NOOVERWRITE maps. */
+static bool wined3d_cs_upload_ring_can_map(struct wined3d_resource *resource, uint32_t flags)
+{
+    if (flags & (WINED3D_MAP_READ | WINED3D_MAP_NOOVERWRITE))
+        return false;
+
+    if (flags & WINED3D_MAP_DISCARD)
+    {
+        if (resource->type != WINED3D_RTYPE_BUFFER)
+            return false;
+        /* Let the CS handle DISCARD maps if it can set up a persistent
+         * mapping; subsequent NOOVERWRITE maps can then use that. */
+        if (wined3d_map_persistent())
+            return false;
+    }
+
+    return true;
+}
+
+static bool wined3d_cs_map_upload_ring(struct wined3d_cs *cs, struct wined3d_resource *resource,
+        unsigned int sub_resource_idx, struct wined3d_map_desc *map_desc, const struct wined3d_box *box, uint32_t flags)
+{
+    struct wined3d_client_resource *client = &resource->client;
+    const struct wined3d_format *format = resource->format;
+    struct wined3d_cs_upload_ring *ring = &cs->upload_ring;
+    size_t size;
+    ULONG end;
+    void *data;
+
+    if (ring->mapped)
+        return false;
+
+    wined3d_format_calculate_pitch(format, 1, box->right - box->left,
+            box->bottom - box->top, &map_desc->row_pitch, &map_desc->slice_pitch);
+
+    size = (box->back - box->front - 1) * map_desc->slice_pitch
+            + ((box->bottom - box->top - 1) / format->block_height) * map_desc->row_pitch
+            + ((box->right - box->left + format->block_width - 1) / format->block_width) * format->block_byte_count;
+
+    if (!(data = wined3d_cs_upload_ring_alloc(cs, size, &end)))
+        return false;
+
+    client->mapped_upload.addr.buffer_object = 0;
+    client->mapped_upload.addr.addr = data;
+    client->mapped_upload.flags = UPLOAD_BO_UPLOAD_ON_UNMAP | UPLOAD_BO_UPLOAD_RING;
+    client->mapped_upload.ring_end = end;
+    client->mapped_box = *box;
+    map_desc->data = data;
+
+    /* Allocations must be released in order, so don't hand out new ones
+     * until this one is submitted. */
+    ring->mapped = TRUE;
+    ring->uploaded_bytes += size;
+    ++ring->upload_count;
+
+    TRACE("Returning upload ring pointer %p.\n", data);
+    return true;
+}
+
 static bool wined3d_cs_map_upload_bo(struct wined3d_device_context *context, struct wined3d_resource *resource,
         unsigned int sub_resource_idx, struct wined3d_map_desc *map_desc, const struct wined3d_box *box, uint32_t flags)
 {
+    struct wined3d_cs *cs = wined3d_cs_from_context(context);
+
     /* Limit NOOVERWRITE maps to buffers for now; there are too many ways that
      * a texture can be invalidated to even count. */
     if (wined3d_map_persistent() && resource->type == WINED3D_RTYPE_BUFFER && (flags & WINED3D_MAP_NOOVERWRITE))
@@ -3155,6 +3316,15 @@ static bool wined3d_cs_map_upload_bo(struct wined3d_device_context *context, str
         return true;
     }
 
+    if (!wined3d_cs_upload_ring_can_map(resource, flags))
+        return false;
+
+    /* Stage the data in the upload ring, so that we don't have to wait for
+     * the CS thread. */
+    if (wined3d_cs_map_upload_ring(cs, resource, sub_resource_idx, map_desc, box, flags))
+        return true;
+
+    ++cs->upload_ring.stall_count;
     return false;
 }
 
@@ -3171,6 +3341,9 @@ static bool wined3d_cs_unmap_upload_bo(struct wined3d_device_context *context, s
     if (wined3d_bo_address_is_null(&client->mapped_upload.addr))
         return false;
 
+    if (client->mapped_upload.flags & UPLOAD_BO_UPLOAD_RING)
+        wined3d_cs_from_context(context)->upload_ring.mapped = FALSE;
+
     *bo = client->mapped_upload;
     *box = client->mapped_box;
     memset(&client->mapped_upload, 0, sizeof(client->mapped_upload));
@@ -3516,8 +3689,12 @@ void wined3d_cs_destroy(struct wined3d_cs *cs)
             ERR("Closing event failed.\n");
     }
 
+    TRACE_(d3d_perf)("Upload ring: %u uploads, %s bytes, %u stalls.\n", cs->upload_ring.upload_count,
+            wine_dbgstr_longlong(cs->upload_ring.uploaded_bytes), cs->upload_ring.stall_count);
+
     wined3d_state_destroy(cs->c.state);
     state_cleanup(&cs->state);
+    heap_free(cs->upload_ring.data);
     heap_free(cs->data);
     heap_free(cs);
 }
@@ -3528,9 +3705,11 @@ struct wined3d_deferred_context
 
     SIZE_T data_size, data_capacity;
     void *data;
+    /* Size of the last recorded command list, used to size the next one. */
+    SIZE_T last_data_size;
 
     SIZE_T resource_count, resources_capacity;
-    struct wined3d_resource **resources;
+    struct wined3d_deferred_resource *resources;
 
     SIZE_T upload_count, uploads_capacity;
     struct wined3d_deferred_upload *uploads;
@@ -3564,7 +3743,8 @@ static void *wined3d_deferred_context_require_space(struct wined3d_device_contex
     packet_size = offsetof(struct wined3d_cs_packet, data[size]);
     packet_size = (packet_size + header_size - 1) & ~(header_size - 1);
 
-    if (!wined3d_array_reserve(&deferred->data, &deferred->data_capacity, deferred->data_size + packet_size, 1))
+    if (!wined3d_array_reserve(&deferred->data, &deferred->data_capacity,
+            max(deferred->data_size + packet_size, deferred->last_data_size), 1))
         return NULL;
 
     packet = (struct wined3d_cs_packet *)((BYTE *)deferred->data + deferred->data_size);
@@ -3718,12 +3898,32 @@ static void wined3d_deferred_context_acquire_resource(struct wined3d_device_cont
         struct wined3d_resource *resource)
 {
     struct wined3d_deferred_context *deferred = wined3d_deferred_context_from_context(context);
+    struct wined3d_deferred_resource *entry;
+    SIZE_T i, start;
+
+    /* Draws and dispatches acquire all bound resources, and these usually
+     * don't change much between calls. Merge them with recently acquired
+     * entries, so that the list doesn't grow with every draw and executing
+     * the command list doesn't need to acquire resources one by one. */
+    start = deferred->resource_count > WINED3D_DEFERRED_RESOURCE_LOOKBACK
+            ? deferred->resource_count - WINED3D_DEFERRED_RESOURCE_LOOKBACK : 0;
+    for (i = deferred->resource_count; i > start; --i)
+    {
+        entry = &deferred->resources[i - 1];
+        if (entry->resource == resource)
+        {
+            ++entry->acquire_count;
+            return;
+        }
+    }
 
     if (!wined3d_array_reserve((void **)&deferred->resources, &deferred->resources_capacity,
             deferred->resource_count + 1, sizeof(*deferred->resources)))
         return;
 
-    deferred->resources[deferred->resource_count++] = resource;
+    entry = &deferred->resources[deferred->resource_count++];
+    entry->resource = resource;
+    entry->acquire_count = 1;
     wined3d_resource_incref(resource);
 }
 
@@ -3792,7 +3992,7 @@ void CDECL wined3d_deferred_context_destroy(struct wined3d_device_context *conte
     TRACE("context %p.\n", context);
 
     for (i = 0; i < deferred->resource_count; ++i)
-        wined3d_resource_decref(deferred->resources[i]);
+        wined3d_resource_decref(deferred->resources[i].resource);
     heap_free(deferred->resources);
 
     for (i = 0; i < deferred->upload_count; ++i)
@@ -3828,8 +4028,7 @@ HRESULT CDECL wined3d_deferred_context_record_command_list(struct wined3d_device
     memory = heap_alloc(sizeof(*object) + deferred->resource_count * sizeof(*object->resources)
             + deferred->upload_count * sizeof(*object->uploads)
             + deferred->command_list_count * sizeof(*object->command_lists)
-            + deferred->query_count * sizeof(*object->queries)
-            + deferred->data_size);
+            + deferred->query_count * sizeof(*object->queries));
 
     if (!memory)
     {
@@ -3868,9 +4067,13 @@ HRESULT CDECL wined3d_deferred_context_record_command_list(struct wined3d_device
     memcpy(object->queries, deferred->queries, deferred->query_count * sizeof(*object->queries));
     /* Transfer our references to the queries to the command list. */
 
-    object->data = memory;
+    /* Hand the recorded commands over to the command list instead of copying
+     * them; the next command list starts with a new buffer. */
+    object->data = deferred->data;
     object->data_size = deferred->data_size;
-    memcpy(object->data, deferred->data, deferred->data_size);
+    deferred->data = NULL;
+    deferred->data_capacity = 0;
+    deferred->last_data_size = deferred->data_size;
 
     deferred->data_size = 0;
     deferred->resource_count = 0;
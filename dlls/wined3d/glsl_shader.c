@@ -256,6 +256,8 @@ struct glsl_shader_prog_link
     DWORD shader_controlled_clip_distances : 1;
     DWORD clip_distance_mask : 8; /* WINED3D_MAX_CLIP_DISTANCES, 8 */
     DWORD padding : 23;
+    /* Non-NULL while the program is still being linked. */
+    struct glsl_program_link_info *pending;
 };
 
 struct glsl_program_key
@@ -549,6 +551,11 @@ void print_glsl_info_log(const struct wined3d_gl_info *gl_info, GLuint id, BOOL
     }
 }
 
+static BOOL shader_glsl_use_async_link(const struct wined3d_gl_info *gl_info)
+{
+    return wined3d_settings.async_shader_compile && gl_info->supported[ARB_PARALLEL_SHADER_COMPILE];
+}
+
 /* Context activation is done by the caller. */
 static void shader_glsl_compile(const struct wined3d_gl_info *gl_info, GLuint shader, const char *src)
 {
@@ -566,7 +573,10 @@ static void shader_glsl_compile(const struct wined3d_gl_info *gl_info, GLuint sh
     checkGLcall("glShaderSource");
     GL_EXTCALL(glCompileShader(shader));
     checkGLcall("glCompileShader");
-    print_glsl_info_log(gl_info, shader, FALSE);
+    /* Querying the info log would wait for compilation to complete. Errors
+     * will still show up when the program is linked. */
+    if (!shader_glsl_use_async_link(gl_info))
+        print_glsl_info_log(gl_info, shader, FALSE);
 }
 
 /* Context activation is done by the caller. */
@@ -639,6 +649,153 @@ void shader_glsl_validate_link(const struct wined3d_gl_info *gl_info, GLuint pro
     print_glsl_info_log(gl_info, program, TRUE);
 }
 
+struct glsl_link_params
+{
+    WORD attribs_map;
+    WORD dual_source;
+    DWORD vs_major;
+};
+
+struct glsl_program_link_info
+{
+    struct wined3d_shader *vshader, *hshader, *dshader, *gshader, *pshader;
+    struct glsl_link_params params;
+    BOOL cache_binary;
+};
+
+/* Context activation is done by the caller. */
+static BOOL shader_glsl_build_cache_key(const struct wined3d_gl_info *gl_info, GLuint program,
+        const void *link_params, SIZE_T link_params_size, struct wined3d_shader_cache_key *key)
+{
+    GLint i, shader_count, source_size = 0, tmp;
+    GLuint *shaders;
+    char *source = NULL;
+
+    wined3d_shader_cache_key_append_string(key, "glsl");
+    wined3d_shader_cache_key_append_string(key, (const char *)gl_info->gl_ops.gl.p_glGetString(GL_VENDOR));
+    wined3d_shader_cache_key_append_string(key, (const char *)gl_info->gl_ops.gl.p_glGetString(GL_RENDERER));
+    wined3d_shader_cache_key_append_string(key, (const char *)gl_info->gl_ops.gl.p_glGetString(GL_VERSION));
+    wined3d_shader_cache_key_append(key, link_params, link_params_size);
+
+    GL_EXTCALL(glGetProgramiv(program, GL_ATTACHED_SHADERS, &shader_count));
+    if (!(shaders = heap_calloc(shader_count, sizeof(*shaders))))
+        return FALSE;
+
+    GL_EXTCALL(glGetAttachedShaders(program, shader_count, NULL, shaders));
+    for (i = 0; i < shader_count; ++i)
+    {
+        GL_EXTCALL(glGetShaderiv(shaders[i], GL_SHADER_TYPE, &tmp));
+        wined3d_shader_cache_key_append(key, &tmp, sizeof(tmp));
+
+        GL_EXTCALL(glGetShaderiv(shaders[i], GL_SHADER_SOURCE_LENGTH, &tmp));
+        if (source_size < tmp)
+        {
+            heap_free(source);
+            if (!(source = heap_alloc(tmp)))
+            {
+                heap_free(shaders);
+                return FALSE;
+            }
+            source_size = tmp;
+        }
+        GL_EXTCALL(glGetShaderSource(shaders[i], source_size, NULL, source));
+        wined3d_shader_cache_key_append_string(key, source_size ? source : NULL);
+    }
+    checkGLcall("build program cache key");
+
+    heap_free(source);
+    heap_free(shaders);
+
+    return !key->failed;
+}
+
+/* Start linking "program", using a binary from the persistent shader cache
+ * when possible. "link_params" should contain everything outside the
+ * attached shader sources that influences linking, e.g. attribute bindings.
+ * Returns TRUE if the program binary should be stored in the cache once
+ * linking completes; see shader_glsl_cache_program_binary().
+ *
+ * Context activation is done by the caller. */
+static BOOL shader_glsl_link_program(const struct wined3d_gl_info *gl_info, GLuint program,
+        const void *link_params, SIZE_T link_params_size)
+{
+    struct wined3d_shader_cache_key key = {0};
+    GLenum format;
+    GLint status;
+    SIZE_T size;
+    BYTE *data;
+
+    if (!gl_info->supported[ARB_GET_PROGRAM_BINARY] || !wined3d_shader_cache_enabled()
+            || !shader_glsl_build_cache_key(gl_info, program, link_params, link_params_size, &key))
+    {
+        wined3d_shader_cache_key_cleanup(&key);
+        GL_EXTCALL(glLinkProgram(program));
+        return FALSE;
+    }
+
+    if (wined3d_shader_cache_get(&key, (void **)&data, &size))
+    {
+        if (size > sizeof(format))
+        {
+            memcpy(&format, data, sizeof(format));
+            GL_EXTCALL(glProgramBinary(program, format, data + sizeof(format), size - sizeof(format)));
+            GL_EXTCALL(glGetProgramiv(program, GL_LINK_STATUS, &status));
+            checkGLcall("glProgramBinary");
+        }
+        else
+        {
+            status = GL_FALSE;
+        }
+        heap_free(data);
+
+        if (status)
+        {
+            TRACE("Loaded program %u from the shader cache.\n", program);
+            wined3d_shader_cache_key_cleanup(&key);
+            return FALSE;
+        }
+        /* The driver may reject binaries after e.g. an update; relink and
+         * replace the stale entry. */
+        WARN("Failed to load cached binary for program %u.\n", program);
+    }
+    wined3d_shader_cache_key_cleanup(&key);
+
+    GL_EXTCALL(glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE));
+    GL_EXTCALL(glLinkProgram(program));
+    return TRUE;
+}
+
+/* Context activation is done by the caller. */
+static void shader_glsl_cache_program_binary(const struct wined3d_gl_info *gl_info, GLuint program,
+        const void *link_params, SIZE_T link_params_size)
+{
+    struct wined3d_shader_cache_key key = {0};
+    GLint status, binary_size;
+    GLenum format;
+    BYTE *data;
+
+    GL_EXTCALL(glGetProgramiv(program, GL_LINK_STATUS, &status));
+    GL_EXTCALL(glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &binary_size));
+    checkGLcall("glGetProgramiv");
+    if (!status || binary_size <= 0)
+        return;
+
+    if (!shader_glsl_build_cache_key(gl_info, program, link_params, link_params_size, &key)
+            || !(data = heap_alloc(sizeof(format) + binary_size)))
+    {
+        wined3d_shader_cache_key_cleanup(&key);
+        return;
+    }
+
+    GL_EXTCALL(glGetProgramBinary(program, binary_size, &binary_size, &format, data + sizeof(format)));
+    checkGLcall("glGetProgramBinary");
+    memcpy(data, &format, sizeof(format));
+    wined3d_shader_cache_put(&key, data, sizeof(format) + binary_size);
+
+    heap_free(data);
+    wined3d_shader_cache_key_cleanup(&key);
+}
+
 static BOOL shader_glsl_use_layout_qualifier(const struct wined3d_gl_info *gl_info)
 {
     /* Layout qualifiers were introduced in GLSL 1.40. The Nvidia Legacy GPU
@@ -6878,6 +7035,7 @@ static void delete_glsl_program_entry(struct shader_glsl_priv *priv, const struc
         list_remove(&entry->ps.shader_entry);
     if (entry->cs.id)
         list_remove(&entry->cs.shader_entry);
+    heap_free(entry->pending);
     heap_free(entry);
 }
 
@@ -10137,6 +10295,7 @@ static HRESULT shader_glsl_compile_compute_shader(struct shader_glsl_priv *priv,
     entry->constant_version = 0;
     entry->shader_controlled_clip_distances = 0;
     entry->ps.np2_fixup_info = NULL;
+    entry->pending = NULL;
     add_glsl_program_entry(priv, entry);
 
     TRACE("Attaching GLSL shader object %u to program %u.\n", shader_id, program_id);
@@ -10146,7 +10305,8 @@ static HRESULT shader_glsl_compile_compute_shader(struct shader_glsl_priv *priv,
     list_add_head(&shader->linked_programs, &entry->cs.shader_entry);
 
     TRACE("Linking GLSL shader program %u.\n", program_id);
-    GL_EXTCALL(glLinkProgram(program_id));
+    if (shader_glsl_link_program(gl_info, program_id, NULL, 0))
+        shader_glsl_cache_program_binary(gl_info, program_id, NULL, 0);
     shader_glsl_validate_link(gl_info, program_id);
 
     GL_EXTCALL(glUseProgram(program_id));
@@ -10206,13 +10366,182 @@ static void set_glsl_compute_shader_program(const struct wined3d_context_gl *con
     ctx_data->glsl_program = entry;
 }
 
+/* Context activation is done by the caller. */
+static void shader_glsl_init_program(const struct wined3d_context_gl *context_gl, struct shader_glsl_priv *priv,
+        struct glsl_shader_prog_link *entry, const struct glsl_program_link_info *link_info)
+{
+    const struct wined3d_gl_info *gl_info = context_gl->gl_info;
+    const struct wined3d_shader *pre_rasterization_shader;
+    const struct wined3d_shader *vshader = link_info->vshader;
+    const struct wined3d_shader *hshader = link_info->hshader;
+    const struct wined3d_shader *dshader = link_info->dshader;
+    const struct wined3d_shader *gshader = link_info->gshader;
+    const struct wined3d_shader *pshader = link_info->pshader;
+    GLuint program_id = entry->id;
+    unsigned int i;
+
+    if (link_info->cache_binary)
+        shader_glsl_cache_program_binary(gl_info, program_id, &link_info->params, sizeof(link_info->params));
+    shader_glsl_validate_link(gl_info, program_id);
+
+    shader_glsl_init_vs_uniform_locations(gl_info, priv, program_id, &entry->vs,
+            vshader ? vshader->limits->constant_float : 0);
+    shader_glsl_init_ds_uniform_locations(gl_info, priv, program_id, &entry->ds);
+    shader_glsl_init_gs_uniform_locations(gl_info, priv, program_id, &entry->gs);
+    shader_glsl_init_ps_uniform_locations(gl_info, priv, program_id, &entry->ps,
+            pshader ? pshader->limits->constant_float : 0);
+    checkGLcall("find glsl program uniform locations");
+
+    pre_rasterization_shader = gshader ? gshader : dshader ? dshader : vshader;
+    if (pre_rasterization_shader && pre_rasterization_shader->reg_maps.shader_version.major >= 4)
+    {
+        unsigned int clip_distance_count = wined3d_popcount(pre_rasterization_shader->reg_maps.clip_distance_mask);
+        entry->shader_controlled_clip_distances = 1;
+        entry->clip_distance_mask = (1u << clip_distance_count) - 1;
+    }
+
+    if (needs_legacy_glsl_syntax(gl_info))
+    {
+        if (pshader && pshader->reg_maps.shader_version.major >= 3
+                && pshader->u.ps.declared_in_count > vec4_varyings(3, gl_info))
+        {
+            TRACE("Shader %d needs vertex color clamping disabled.\n", program_id);
+            entry->vs.vertex_color_clamp = GL_FALSE;
+        }
+        else
+        {
+            entry->vs.vertex_color_clamp = GL_FIXED_ONLY_ARB;
+        }
+    }
+    else
+    {
+        /* With core profile we never change vertex_color_clamp from
+         * GL_FIXED_ONLY_MODE (which is also the initial value) so we never call
+         * glClampColorARB(). */
+        entry->vs.vertex_color_clamp = GL_FIXED_ONLY_ARB;
+    }
+
+    /* Set the shader to allow uniform loading on it */
+    GL_EXTCALL(glUseProgram(program_id));
+    checkGLcall("glUseProgram");
+
+    entry->constant_update_mask = 0;
+    if (vshader)
+    {
+        entry->constant_update_mask |= WINED3D_SHADER_CONST_VS_F;
+        if (vshader->reg_maps.integer_constants)
+            entry->constant_update_mask |= WINED3D_SHADER_CONST_VS_I;
+        if (vshader->reg_maps.boolean_constants)
+            entry->constant_update_mask |= WINED3D_SHADER_CONST_VS_B;
+        if (entry->vs.pos_fixup_location != -1)
+            entry->constant_update_mask |= WINED3D_SHADER_CONST_POS_FIXUP;
+        if (entry->vs.base_vertex_id_location != -1)
+            entry->constant_update_mask |= WINED3D_SHADER_CONST_BASE_VERTEX_ID;
+
+        shader_glsl_load_program_resources(context_gl, priv, program_id, vshader);
+    }
+    else
+    {
+        entry->constant_update_mask |= WINED3D_SHADER_CONST_FFP_MODELVIEW
+                | WINED3D_SHADER_CONST_FFP_PROJ;
+
+        for (i = 1; i < MAX_VERTEX_BLENDS; ++i)
+        {
+            if (entry->vs.modelview_matrix_location[i] != -1)
+            {
+                entry->constant_update_mask |= WINED3D_SHADER_CONST_FFP_VERTEXBLEND;
+                break;
+            }
+        }
+
+        for (i = 0; i < WINED3D_MAX_TEXTURES; ++i)
+        {
+            if (entry->vs.texture_matrix_location[i] != -1)
+            {
+                entry->constant_update_mask |= WINED3D_SHADER_CONST_FFP_TEXMATRIX;
+                break;
+            }
+        }
+        if (entry->vs.material_ambient_location != -1 || entry->vs.material_diffuse_location != -1
+                || entry->vs.material_specular_location != -1
+                || entry->vs.material_emissive_location != -1
+                || entry->vs.material_shininess_location != -1)
+            entry->constant_update_mask |= WINED3D_SHADER_CONST_FFP_MATERIAL;
+        if (entry->vs.light_ambient_location != -1)
+            entry->constant_update_mask |= WINED3D_SHADER_CONST_FFP_LIGHTS;
+    }
+    if (entry->vs.clip_planes_location != -1)
+        entry->constant_update_mask |= WINED3D_SHADER_CONST_VS_CLIP_PLANES;
+    if (entry->vs.pointsize_min_location != -1)
+        entry->constant_update_mask |= WINED3D_SHADER_CONST_VS_POINTSIZE;
+
+    if (hshader)
+        shader_glsl_load_program_resources(context_gl, priv, program_id, hshader);
+
+    if (dshader)
+    {
+        if (entry->ds.pos_fixup_location != -1)
+            entry->constant_update_mask |= WINED3D_SHADER_CONST_POS_FIXUP;
+
+        shader_glsl_load_program_resources(context_gl, priv, program_id, dshader);
+    }
+
+    if (gshader)
+    {
+        if (entry->gs.pos_fixup_location != -1)
+            entry->constant_update_mask |= WINED3D_SHADER_CONST_POS_FIXUP;
+
+        shader_glsl_load_program_resources(context_gl, priv, program_id, gshader);
+    }
+
+    if (entry->ps.id)
+    {
+        if (pshader)
+        {
+            entry->constant_update_mask |= WINED3D_SHADER_CONST_PS_F;
+            if (pshader->reg_maps.integer_constants)
+                entry->constant_update_mask |= WINED3D_SHADER_CONST_PS_I;
+            if (pshader->reg_maps.boolean_constants)
+                entry->constant_update_mask |= WINED3D_SHADER_CONST_PS_B;
+            if (entry->ps.ycorrection_location != -1)
+                entry->constant_update_mask |= WINED3D_SHADER_CONST_PS_Y_CORR;
+
+            shader_glsl_load_program_resources(context_gl, priv, program_id, pshader);
+            shader_glsl_load_images(gl_info, priv, program_id, &pshader->reg_maps);
+        }
+        else
+        {
+            entry->constant_update_mask |= WINED3D_SHADER_CONST_FFP_PS;
+
+            shader_glsl_load_samplers(&context_gl->c, priv, program_id, NULL);
+        }
+
+        for (i = 0; i < WINED3D_MAX_TEXTURES; ++i)
+        {
+            if (entry->ps.bumpenv_mat_location[i] != -1)
+            {
+                entry->constant_update_mask |= WINED3D_SHADER_CONST_PS_BUMP_ENV;
+                break;
+            }
+        }
+
+        if (entry->ps.fog_color_location != -1)
+            entry->constant_update_mask |= WINED3D_SHADER_CONST_PS_FOG;
+        if (entry->ps.alpha_test_ref_location != -1)
+            entry->constant_update_mask |= WINED3D_SHADER_CONST_PS_ALPHA_TEST;
+        if (entry->ps.np2_fixup_location != -1)
+            entry->constant_update_mask |= WINED3D_SHADER_CONST_PS_NP2_FIXUP;
+        if (entry->ps.color_key_location != -1)
+            entry->constant_update_mask |= WINED3D_SHADER_CONST_FFP_COLOR_KEY;
+    }
+}
+
 /* Context activation is done by the caller. */
 static void set_glsl_shader_program(const struct wined3d_context_gl *context_gl, const struct wined3d_state *state,
         struct shader_glsl_priv *priv, struct glsl_context_data *ctx_data)
 {
     const struct wined3d_d3d_info *d3d_info = context_gl->c.d3d_info;
     const struct wined3d_gl_info *gl_info = context_gl->gl_info;
-    const struct wined3d_shader *pre_rasterization_shader;
     const struct ps_np2fixup_info *np2fixup_info = NULL;
     struct wined3d_shader *hshader, *dshader, *gshader;
     struct glsl_shader_prog_link *entry = NULL;
@@ -10228,6 +10557,7 @@ static void set_glsl_shader_program(const struct wined3d_context_gl *context_gl,
     GLuint gs_id = 0;
     GLuint ps_id = 0;
     struct list *ps_list, *vs_list;
+    struct glsl_program_link_info link_info;
     WORD attribs_map;
     struct wined3d_string_buffer *tmp_name;
 
@@ -10356,6 +10686,7 @@ static void set_glsl_shader_program(const struct wined3d_context_gl *context_gl,
     entry->constant_version = 0;
     entry->shader_controlled_clip_distances = 0;
     entry->ps.np2_fixup_info = np2fixup_info;
+    entry->pending = NULL;
     /* Add the hash table entry */
     add_glsl_program_entry(priv, entry);
 
@@ -10394,6 +10725,11 @@ static void set_glsl_shader_program(const struct wined3d_context_gl *context_gl,
         attribs_map = (1u << WINED3D_FFP_ATTRIBS_COUNT) - 1;
     }
 
+    memset(&link_info.params, 0, sizeof(link_info.params));
+    link_info.params.attribs_map = attribs_map;
+    link_info.params.vs_major = vshader ? vshader->reg_maps.shader_version.major : 0;
+    link_info.params.dual_source = state->blend_state && state->blend_state->dual_source;
+
     if (!shader_glsl_use_explicit_attrib_location(gl_info))
     {
         /* Bind vertex attributes to a corresponding index number to match
@@ -10479,159 +10815,52 @@ static void set_glsl_shader_program(const struct wined3d_context_gl *context_gl,
 
     /* Link the program */
     TRACE("Linking GLSL shader program %u.\n", program_id);
-    GL_EXTCALL(glLinkProgram(program_id));
-    shader_glsl_validate_link(gl_info, program_id);
-
-    shader_glsl_init_vs_uniform_locations(gl_info, priv, program_id, &entry->vs,
-            vshader ? vshader->limits->constant_float : 0);
-    shader_glsl_init_ds_uniform_locations(gl_info, priv, program_id, &entry->ds);
-    shader_glsl_init_gs_uniform_locations(gl_info, priv, program_id, &entry->gs);
-    shader_glsl_init_ps_uniform_locations(gl_info, priv, program_id, &entry->ps,
-            pshader ? pshader->limits->constant_float : 0);
-    checkGLcall("find glsl program uniform locations");
-
-    pre_rasterization_shader = gshader ? gshader : dshader ? dshader : vshader;
-    if (pre_rasterization_shader && pre_rasterization_shader->reg_maps.shader_version.major >= 4)
-    {
-        unsigned int clip_distance_count = wined3d_popcount(pre_rasterization_shader->reg_maps.clip_distance_mask);
-        entry->shader_controlled_clip_distances = 1;
-        entry->clip_distance_mask = (1u << clip_distance_count) - 1;
-    }
-
-    if (needs_legacy_glsl_syntax(gl_info))
-    {
-        if (pshader && pshader->reg_maps.shader_version.major >= 3
-                && pshader->u.ps.declared_in_count > vec4_varyings(3, gl_info))
-        {
-            TRACE("Shader %d needs vertex color clamping disabled.\n", program_id);
-            entry->vs.vertex_color_clamp = GL_FALSE;
-        }
-        else
-        {
-            entry->vs.vertex_color_clamp = GL_FIXED_ONLY_ARB;
-        }
-    }
-    else
-    {
-        /* With core profile we never change vertex_color_clamp from
-         * GL_FIXED_ONLY_MODE (which is also the initial value) so we never call
-         * glClampColorARB(). */
-        entry->vs.vertex_color_clamp = GL_FIXED_ONLY_ARB;
-    }
-
-    /* Set the shader to allow uniform loading on it */
-    GL_EXTCALL(glUseProgram(program_id));
-    checkGLcall("glUseProgram");
-
-    entry->constant_update_mask = 0;
-    if (vshader)
+    link_info.vshader = vshader;
+    link_info.hshader = hshader;
+    link_info.dshader = dshader;
+    link_info.gshader = gshader;
+    link_info.pshader = pshader;
+    /* Transform feedback varyings aren't part of the cache key. */
+    if (gshader && gshader->u.gs.so_desc)
     {
-        entry->constant_update_mask |= WINED3D_SHADER_CONST_VS_F;
-        if (vshader->reg_maps.integer_constants)
-            entry->constant_update_mask |= WINED3D_SHADER_CONST_VS_I;
-        if (vshader->reg_maps.boolean_constants)
-            entry->constant_update_mask |= WINED3D_SHADER_CONST_VS_B;
-        if (entry->vs.pos_fixup_location != -1)
-            entry->constant_update_mask |= WINED3D_SHADER_CONST_POS_FIXUP;
-        if (entry->vs.base_vertex_id_location != -1)
-            entry->constant_update_mask |= WINED3D_SHADER_CONST_BASE_VERTEX_ID;
-
-        shader_glsl_load_program_resources(context_gl, priv, program_id, vshader);
+        GL_EXTCALL(glLinkProgram(program_id));
+        link_info.cache_binary = FALSE;
     }
     else
     {
-        entry->constant_update_mask |= WINED3D_SHADER_CONST_FFP_MODELVIEW
-                | WINED3D_SHADER_CONST_FFP_PROJ;
-
-        for (i = 1; i < MAX_VERTEX_BLENDS; ++i)
-        {
-            if (entry->vs.modelview_matrix_location[i] != -1)
-            {
-                entry->constant_update_mask |= WINED3D_SHADER_CONST_FFP_VERTEXBLEND;
-                break;
-            }
-        }
-
-        for (i = 0; i < WINED3D_MAX_TEXTURES; ++i)
-        {
-            if (entry->vs.texture_matrix_location[i] != -1)
-            {
-                entry->constant_update_mask |= WINED3D_SHADER_CONST_FFP_TEXMATRIX;
-                break;
-            }
-        }
-        if (entry->vs.material_ambient_location != -1 || entry->vs.material_diffuse_location != -1
-                || entry->vs.material_specular_location != -1
-                || entry->vs.material_emissive_location != -1
-                || entry->vs.material_shininess_location != -1)
-            entry->constant_update_mask |= WINED3D_SHADER_CONST_FFP_MATERIAL;
-        if (entry->vs.light_ambient_location != -1)
-            entry->constant_update_mask |= WINED3D_SHADER_CONST_FFP_LIGHTS;
-    }
-    if (entry->vs.clip_planes_location != -1)
-        entry->constant_update_mask |= WINED3D_SHADER_CONST_VS_CLIP_PLANES;
-    if (entry->vs.pointsize_min_location != -1)
-        entry->constant_update_mask |= WINED3D_SHADER_CONST_VS_POINTSIZE;
-
-    if (hshader)
-        shader_glsl_load_program_resources(context_gl, priv, program_id, hshader);
-
-    if (dshader)
-    {
-        if (entry->ds.pos_fixup_location != -1)
-            entry->constant_update_mask |= WINED3D_SHADER_CONST_POS_FIXUP;
-
-        shader_glsl_load_program_resources(context_gl, priv, program_id, dshader);
+        link_info.cache_binary = shader_glsl_link_program(gl_info, program_id,
+                &link_info.params, sizeof(link_info.params));
     }
 
-    if (gshader)
+    /* With parallel shader compilation, querying anything about the program
+     * would wait for the link to complete. Finish setting up the program
+     * once it's ready instead; see shader_glsl_select(). */
+    if (shader_glsl_use_async_link(gl_info) && (entry->pending = heap_alloc(sizeof(*entry->pending))))
     {
-        if (entry->gs.pos_fixup_location != -1)
-            entry->constant_update_mask |= WINED3D_SHADER_CONST_POS_FIXUP;
-
-        shader_glsl_load_program_resources(context_gl, priv, program_id, gshader);
+        *entry->pending = link_info;
+        return;
     }
 
-    if (ps_id)
-    {
-        if (pshader)
-        {
-            entry->constant_update_mask |= WINED3D_SHADER_CONST_PS_F;
-            if (pshader->reg_maps.integer_constants)
-                entry->constant_update_mask |= WINED3D_SHADER_CONST_PS_I;
-            if (pshader->reg_maps.boolean_constants)
-                entry->constant_update_mask |= WINED3D_SHADER_CONST_PS_B;
-            if (entry->ps.ycorrection_location != -1)
-                entry->constant_update_mask |= WINED3D_SHADER_CONST_PS_Y_CORR;
+    shader_glsl_init_program(context_gl, priv, entry, &link_info);
+}
 
-            shader_glsl_load_program_resources(context_gl, priv, program_id, pshader);
-            shader_glsl_load_images(gl_info, priv, program_id, &pshader->reg_maps);
-        }
-        else
-        {
-            entry->constant_update_mask |= WINED3D_SHADER_CONST_FFP_PS;
+/* Context activation is done by the caller. */
+static BOOL shader_glsl_complete_program(const struct wined3d_context_gl *context_gl,
+        struct shader_glsl_priv *priv, struct glsl_shader_prog_link *entry)
+{
+    const struct wined3d_gl_info *gl_info = context_gl->gl_info;
+    GLint status;
 
-            shader_glsl_load_samplers(&context_gl->c, priv, program_id, NULL);
-        }
+    GL_EXTCALL(glGetProgramiv(entry->id, GL_COMPLETION_STATUS_ARB, &status));
+    checkGLcall("glGetProgramiv");
+    if (!status)
+        return FALSE;
 
-        for (i = 0; i < WINED3D_MAX_TEXTURES; ++i)
-        {
-            if (entry->ps.bumpenv_mat_location[i] != -1)
-            {
-                entry->constant_update_mask |= WINED3D_SHADER_CONST_PS_BUMP_ENV;
-                break;
-            }
-        }
+    shader_glsl_init_program(context_gl, priv, entry, entry->pending);
+    heap_free(entry->pending);
+    entry->pending = NULL;
 
-        if (entry->ps.fog_color_location != -1)
-            entry->constant_update_mask |= WINED3D_SHADER_CONST_PS_FOG;
-        if (entry->ps.alpha_test_ref_location != -1)
-            entry->constant_update_mask |= WINED3D_SHADER_CONST_PS_ALPHA_TEST;
-        if (entry->ps.np2_fixup_location != -1)
-            entry->constant_update_mask |= WINED3D_SHADER_CONST_PS_NP2_FIXUP;
-        if (entry->ps.color_key_location != -1)
-            entry->constant_update_mask |= WINED3D_SHADER_CONST_FFP_COLOR_KEY;
-    }
+    return TRUE;
 }
 
 static void shader_glsl_precompile(void *shader_priv, struct wined3d_shader *shader)
@@ -10666,6 +10895,14 @@ static void shader_glsl_select(void *shader_priv, struct wined3d_context *contex
     set_glsl_shader_program(context_gl, state, priv, ctx_data);
     glsl_program = ctx_data->glsl_program;
 
+    context->shader_program_pending = 0;
+    if (glsl_program && glsl_program->pending && !shader_glsl_complete_program(context_gl, priv, glsl_program))
+    {
+        TRACE("Program %u is still being linked.\n", glsl_program->id);
+        ctx_data->glsl_program = glsl_program = NULL;
+        context->shader_program_pending = 1;
+    }
+
     if (glsl_program)
     {
         program_id = glsl_program->id;
@@ -0,0 +1,236 @@
+/*
+ * Persistent shader cache
+ *
+ * Copyright 2026 agent
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "config.h"
+#include "wine/port.h"
+
+#include <stdio.h>
+
+#include "wined3d_private.h"
+
+WINE_DEFAULT_DEBUG_CHANNEL(d3d_shader);
+WINE_DECLARE_DEBUG_CHANNEL(d3d_perf);
+
+/* Cache entries are stored in files named after a hash of their key. Each
+ * file starts with a header, followed by the full key, which is compared
+ * against the requested key on lookup, and the cached data. */
+#define WINED3D_SHADER_CACHE_MAGIC   0x43533357u /* "W3SC" */
+#define WINED3D_SHADER_CACHE_VERSION 1u
+
+struct wined3d_shader_cache_header
+{
+    uint32_t magic;
+    uint32_t version;
+    uint64_t key_size;
+    uint64_t data_size;
+};
+
+static struct
+{
+    LONG hits;
+    LONG misses;
+    LONG stores;
+    LONG store_failures;
+} shader_cache_stats;
+
+static BOOL WINAPI shader_cache_init_once(INIT_ONCE *once, void *param, void **context)
+{
+    const char *path = wined3d_settings.shader_cache_path;
+
+    if (!CreateDirectoryA(path, NULL) && GetLastError() != ERROR_ALREADY_EXISTS)
+    {
+        ERR("Failed to create shader cache directory %s, error %u.\n", debugstr_a(path), GetLastError());
+        return FALSE;
+    }
+
+    TRACE("Using shader cache directory %s.\n", debugstr_a(path));
+    return TRUE;
+}
+
+BOOL wined3d_shader_cache_enabled(void)
+{
+    static INIT_ONCE init_once = INIT_ONCE_STATIC_INIT;
+
+    if (!wined3d_settings.shader_cache_path)
+        return FALSE;
+    return InitOnceExecuteOnce(&init_once, shader_cache_init_once, NULL, NULL);
+}
+
+void wined3d_shader_cache_key_append(struct wined3d_shader_cache_key *key, const void *data, SIZE_T size)
+{
+    if (key->failed || !size)
+        return;
+
+    if (!wined3d_array_reserve((void **)&key->data, &key->capacity, key->size + size, 1))
+    {
+        key->failed = TRUE;
+        return;
+    }
+
+    memcpy(key->data + key->size, data, size);
+    key->size += size;
+}
+
+void wined3d_shader_cache_key_append_string(struct wined3d_shader_cache_key *key, const char *str)
+{
+    /* Include the terminator, so that consecutive strings can't be confused. */
+    wined3d_shader_cache_key_append(key, str ? str : "", str ? strlen(str) + 1 : 1);
+}
+
+void wined3d_shader_cache_key_cleanup(struct wined3d_shader_cache_key *key)
+{
+    heap_free(key->data);
+}
+
+static uint64_t shader_cache_hash(const struct wined3d_shader_cache_key *key)
+{
+    uint64_t hash = 0xcbf29ce484222325ull;
+    SIZE_T i;
+
+    /* 64-bit FNV-1a. */
+    for (i = 0; i < key->size; ++i)
+    {
+        hash ^= key->data[i];
+        hash *= 0x100000001b3ull;
+    }
+
+    return hash;
+}
+
+static void shader_cache_get_file_name(const struct wined3d_shader_cache_key *key, char *name, size_t size)
+{
+    uint64_t hash = shader_cache_hash(key);
+
+    snprintf(name, size, "%s\\%08x%08x.bin", wined3d_settings.shader_cache_path,
+            (unsigned int)(hash >> 32), (unsigned int)hash);
+}
+
+static BOOL shader_cache_read(HANDLE file, void *data, DWORD size)
+{
+    DWORD read;
+
+    return ReadFile(file, data, size, &read, NULL) && read == size;
+}
+
+BOOL wined3d_shader_cache_get(const struct wined3d_shader_cache_key *key, void **data, SIZE_T *size)
+{
+    struct wined3d_shader_cache_header header;
+    BYTE *stored_key = NULL;
+    char name[MAX_PATH];
+    void *ret = NULL;
+    BOOL found = FALSE;
+    HANDLE file;
+
+    if (key->failed || !wined3d_shader_cache_enabled())
+        return FALSE;
+
+    shader_cache_get_file_name(key, name, sizeof(name));
+    if ((file = CreateFileA(name, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL,
+            OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL)) == INVALID_HANDLE_VALUE)
+    {
+        InterlockedIncrement(&shader_cache_stats.misses);
+        return FALSE;
+    }
+
+    if (!shader_cache_read(file, &header, sizeof(header)) || header.magic != WINED3D_SHADER_CACHE_MAGIC
+            || header.version != WINED3D_SHADER_CACHE_VERSION || header.key_size != key->size
+            || !header.data_size || header.data_size > ~(DWORD)0)
+        goto done;
+
+    if (!(stored_key = heap_alloc(key->size)) || !(ret = heap_alloc(header.data_size)))
+        goto done;
+
+    if (!shader_cache_read(file, stored_key, key->size) || memcmp(stored_key, key->data, key->size))
+    {
+        TRACE("Hash collision for cache entry %s.\n", debugstr_a(name));
+        goto done;
+    }
+
+    if (!shader_cache_read(file, ret, header.data_size))
+        goto done;
+
+    *data = ret;
+    *size = header.data_size;
+    ret = NULL;
+    found = TRUE;
+
+done:
+    CloseHandle(file);
+    heap_free(stored_key);
+    heap_free(ret);
+
+    InterlockedIncrement(found ? &shader_cache_stats.hits : &shader_cache_stats.misses);
+    return found;
+}
+
+void wined3d_shader_cache_put(const struct wined3d_shader_cache_key *key, const void *data, SIZE_T size)
+{
+    struct wined3d_shader_cache_header header;
+    char name[MAX_PATH], tmp_name[MAX_PATH];
+    BOOL ret = FALSE;
+    DWORD written;
+    HANDLE file;
+
+    if (key->failed || !size || !wined3d_shader_cache_enabled())
+        return;
+
+    /* Write to a temporary file first, so that other processes never see
+     * partially written entries. */
+    shader_cache_get_file_name(key, name, sizeof(name));
+    snprintf(tmp_name, sizeof(tmp_name), "%s.%x", name, GetCurrentThreadId());
+    if ((file = CreateFileA(tmp_name, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS,
+            FILE_ATTRIBUTE_NORMAL, NULL)) == INVALID_HANDLE_VALUE)
+    {
+        WARN("Failed to create %s, error %u.\n", debugstr_a(tmp_name), GetLastError());
+        InterlockedIncrement(&shader_cache_stats.store_failures);
+        return;
+    }
+
+    header.magic = WINED3D_SHADER_CACHE_MAGIC;
+    header.version = WINED3D_SHADER_CACHE_VERSION;
+    header.key_size = key->size;
+    header.data_size = size;
+
+    if (WriteFile(file, &header, sizeof(header), &written, NULL) && written == sizeof(header)
+            && WriteFile(file, key->data, key->size, &written, NULL) && written == key->size
+            && WriteFile(file, data, size, &written, NULL) && written == size)
+        ret = TRUE;
+    CloseHandle(file);
+
+    if (!ret || !MoveFileExA(tmp_name, name, MOVEFILE_REPLACE_EXISTING))
+    {
+        WARN("Failed to write cache entry %s, error %u.\n", debugstr_a(name), GetLastError());
+        DeleteFileA(tmp_name);
+        InterlockedIncrement(&shader_cache_stats.store_failures);
+        return;
+    }
+
+    InterlockedIncrement(&shader_cache_stats.stores);
+}
+
+void wined3d_shader_cache_dump_stats(void)
+{
+    if (!wined3d_settings.shader_cache_path)
+        return;
+
+    TRACE_(d3d_perf)("Shader cache: %d hits, %d misses, %d stores, %d failed stores.\n",
+            shader_cache_stats.hits, shader_cache_stats.misses,
+            shader_cache_stats.stores, shader_cache_stats.store_failures);
+}
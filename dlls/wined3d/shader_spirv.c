@@ -303,6 +303,28 @@ static void shader_spirv_init_shader_interface_vk(struct wined3d_shader_spirv_sh
     iface->vkd3d_interface.uav_counter_count = b->uav_counter_count;
 }
 
+static void shader_spirv_build_cache_key(struct wined3d_shader_cache_key *key,
+        const struct wined3d_shader_desc *shader_desc, enum wined3d_shader_type shader_type,
+        const struct shader_spirv_compile_arguments *args, const struct shader_spirv_resource_bindings *bindings)
+{
+    BYTE has_args = !!args;
+
+    wined3d_shader_cache_key_append_string(key, "spirv");
+    wined3d_shader_cache_key_append_string(key, vkd3d_shader_get_version(NULL, NULL));
+    wined3d_shader_cache_key_append(key, &shader_type, sizeof(shader_type));
+    /* Compute shaders don't have compile arguments. */
+    wined3d_shader_cache_key_append(key, &has_args, sizeof(has_args));
+    if (args)
+        wined3d_shader_cache_key_append(key, args, sizeof(*args));
+    wined3d_shader_cache_key_append(key, &bindings->binding_count, sizeof(bindings->binding_count));
+    wined3d_shader_cache_key_append(key, bindings->bindings,
+            bindings->binding_count * sizeof(*bindings->bindings));
+    wined3d_shader_cache_key_append(key, &bindings->uav_counter_count, sizeof(bindings->uav_counter_count));
+    wined3d_shader_cache_key_append(key, bindings->uav_counters,
+            bindings->uav_counter_count * sizeof(*bindings->uav_counters));
+    wined3d_shader_cache_key_append(key, shader_desc->byte_code, shader_desc->byte_code_size);
+}
+
 static VkShaderModule shader_spirv_compile_shader(struct wined3d_context_vk *context_vk,
         const struct wined3d_shader_desc *shader_desc, enum wined3d_shader_type shader_type,
         const struct shader_spirv_compile_arguments *args, const struct shader_spirv_resource_bindings *bindings,
@@ -310,16 +332,33 @@ static VkShaderModule shader_spirv_compile_shader(struct wined3d_context_vk *con
 {
     struct wined3d_shader_spirv_compile_args compile_args;
     struct wined3d_shader_spirv_shader_interface iface;
+    struct wined3d_shader_cache_key key = {0};
     VkShaderModuleCreateInfo shader_create_info;
+    struct vkd3d_shader_code spirv = {NULL, 0};
     struct vkd3d_shader_compile_info info;
     const struct wined3d_vk_info *vk_info;
     struct wined3d_device_vk *device_vk;
-    struct vkd3d_shader_code spirv;
+    void *cached_code = NULL;
     VkShaderModule module;
+    SIZE_T cached_size;
     char *messages;
     VkResult vr;
     int ret;
 
+    /* Stream output declarations aren't part of the key; these shaders are
+     * rare enough to not be worth caching. */
+    if (!so_desc && wined3d_shader_cache_enabled())
+    {
+        shader_spirv_build_cache_key(&key, shader_desc, shader_type, args, bindings);
+        if (wined3d_shader_cache_get(&key, &cached_code, &cached_size))
+        {
+            TRACE("Using cached SPIR-V code.\n");
+            spirv.code = cached_code;
+            spirv.size = cached_size;
+            goto create_module;
+        }
+    }
+
     shader_spirv_init_shader_interface_vk(&iface, bindings, so_desc);
     shader_spirv_init_compile_args(&compile_args, &iface.vkd3d_interface,
             VKD3D_SHADER_SPIRV_ENVIRONMENT_VULKAN_1_0, shader_type, args);
@@ -353,9 +392,15 @@ static VkShaderModule shader_spirv_compile_shader(struct wined3d_context_vk *con
     if (ret < 0)
     {
         ERR("Failed to compile DXBC, ret %d.\n", ret);
+        wined3d_shader_cache_key_cleanup(&key);
         return VK_NULL_HANDLE;
     }
 
+    if (key.size)
+        wined3d_shader_cache_put(&key, spirv.code, spirv.size);
+
+create_module:
+    wined3d_shader_cache_key_cleanup(&key);
     device_vk = wined3d_device_vk(context_vk->c.device);
     vk_info = &device_vk->vk_info;
 
@@ -364,15 +409,17 @@ static VkShaderModule shader_spirv_compile_shader(struct wined3d_context_vk *con
     shader_create_info.flags = 0;
     shader_create_info.codeSize = spirv.size;
     shader_create_info.pCode = spirv.code;
-    if ((vr = VK_CALL(vkCreateShaderModule(device_vk->vk_device, &shader_create_info, NULL, &module))) < 0)
-    {
+    vr = VK_CALL(vkCreateShaderModule(device_vk->vk_device, &shader_create_info, NULL, &module));
+    if (cached_code)
+        heap_free(cached_code);
+    else
         vkd3d_shader_free_shader_code(&spirv);
+    if (vr < 0)
+    {
         WARN("Failed to create Vulkan shader module, vr %s.\n", wined3d_debug_vkresult(vr));
         return VK_NULL_HANDLE;
     }
 
-    vkd3d_shader_free_shader_code(&spirv);
-
     return module;
 }
 
@@ -60,6 +60,9 @@ void wined3d_swapchain_cleanup(struct wined3d_swapchain *swapchain)
         swapchain->back_buffers = NULL;
     }
 
+    heap_free(swapchain->frame_times);
+    swapchain->frame_times = NULL;
+
     /* Restore the screen resolution if we rendered in fullscreen.
      * This will restore the screen resolution to what it was before creating
      * the swapchain. In case of d3d8 and d3d9 this will be the original
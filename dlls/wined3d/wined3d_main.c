@@ -362,6 +362,12 @@ static BOOL wined3d_dll_init(HINSTANCE hInstDLL)
             TRACE("Checking relative addressing indices in float constants.\n");
             wined3d_settings.check_float_constants = TRUE;
         }
+        if (!get_config_key(hkey, appkey, "AsyncShaderCompile", buffer, size)
+                && !strcmp(buffer, "enabled"))
+        {
+            TRACE("Linking GLSL programs asynchronously.\n");
+            wined3d_settings.async_shader_compile = TRUE;
+        }
         if (!get_config_key_dword(hkey, appkey, "strict_shader_math", &wined3d_settings.strict_shader_math))
             ERR_(winediag)("Setting strict shader math to %#x.\n", wined3d_settings.strict_shader_math);
         if (!get_config_key_dword(hkey, appkey, "MaxShaderModelVS", &wined3d_settings.max_sm_vs))
@@ -399,6 +405,18 @@ static BOOL wined3d_dll_init(HINSTANCE hInstDLL)
             TRACE("Forcing all constant buffers to be write-mappable.\n");
             wined3d_settings.cb_access_map_w = TRUE;
         }
+        if (!get_config_key(hkey, appkey, "ShaderCachePath", buffer, size) && *buffer)
+        {
+            size_t len = strlen(buffer) + 1;
+
+            if (!(wined3d_settings.shader_cache_path = heap_alloc(len)))
+                ERR("Failed to allocate shader cache path memory.\n");
+            else
+            {
+                memcpy(wined3d_settings.shader_cache_path, buffer, len);
+                TRACE("Using shader cache path %s.\n", debugstr_a(buffer));
+            }
+        }
     }
 
     if (appkey) RegCloseKey( appkey );
@@ -413,6 +431,7 @@ static BOOL wined3d_dll_destroy(HINSTANCE hInstDLL)
     unsigned int i;
 
     wined3d_spirv_shader_backend_cleanup();
+    wined3d_shader_cache_dump_stats();
 
     if (!TlsFree(wined3d_context_tls_idx))
     {
@@ -441,6 +460,7 @@ static BOOL wined3d_dll_destroy(HINSTANCE hInstDLL)
     heap_free(swapchain_state_table.hooks);
 
     heap_free(wined3d_settings.logo);
+    heap_free(wined3d_settings.shader_cache_path);
     UnregisterClassA(WINED3D_OPENGL_WINDOW_CLASS_NAME, hInstDLL);
 
     DeleteCriticalSection(&wined3d_command_cs);
@@ -495,6 +495,8 @@ struct wined3d_settings
     enum wined3d_renderer renderer;
     enum wined3d_shader_backend shader_backend;
     BOOL cb_access_map_w;
+    char *shader_cache_path;
+    BOOL async_shader_compile;
 };
 
 extern struct wined3d_settings wined3d_settings DECLSPEC_HIDDEN;
@@ -1538,6 +1540,23 @@ extern const struct wined3d_shader_backend_ops none_shader_backend DECLSPEC_HIDD
 const struct wined3d_shader_backend_ops *wined3d_spirv_shader_backend_init_vk(void) DECLSPEC_HIDDEN;
 void wined3d_spirv_shader_backend_cleanup(void) DECLSPEC_HIDDEN;
 
+struct wined3d_shader_cache_key
+{
+    BYTE *data;
+    SIZE_T size, capacity;
+    BOOL failed;
+};
+
+BOOL wined3d_shader_cache_enabled(void) DECLSPEC_HIDDEN;
+void wined3d_shader_cache_key_append(struct wined3d_shader_cache_key *key,
+        const void *data, SIZE_T size) DECLSPEC_HIDDEN;
+void wined3d_shader_cache_key_append_string(struct wined3d_shader_cache_key *key, const char *str) DECLSPEC_HIDDEN;
+void wined3d_shader_cache_key_cleanup(struct wined3d_shader_cache_key *key) DECLSPEC_HIDDEN;
+BOOL wined3d_shader_cache_get(const struct wined3d_shader_cache_key *key, void **data, SIZE_T *size) DECLSPEC_HIDDEN;
+void wined3d_shader_cache_put(const struct wined3d_shader_cache_key *key,
+        const void *data, SIZE_T size) DECLSPEC_HIDDEN;
+void wined3d_shader_cache_dump_stats(void) DECLSPEC_HIDDEN;
+
 #define GL_EXTCALL(f) (gl_info->gl_ops.ext.p_##f)
 
 #define D3DCOLOR_B_R(dw) (((dw) >> 16) & 0xff)
@@ -2182,7 +2201,8 @@ struct wined3d_context
     DWORD destroy_delayed : 1;
     DWORD clip_distance_mask : 8; /* WINED3D_MAX_CLIP_DISTANCES, 8 */
     DWORD namedArraysLoaded : 1;
-    DWORD padding : 13;
+    DWORD shader_program_pending : 1;
+    DWORD padding : 12;
 
     DWORD constant_update_mask;
     DWORD numbered_array_mask;
@@ -3343,11 +3363,15 @@ bool wined3d_driver_info_init(struct wined3d_driver_info *driver_info,
         UINT64 vram_bytes, UINT64 sysmem_bytes) DECLSPEC_HIDDEN;
 
 #define UPLOAD_BO_UPLOAD_ON_UNMAP   0x1
+#define UPLOAD_BO_UPLOAD_RING       0x2
 
 struct upload_bo
 {
     struct wined3d_const_bo_address addr;
     uint32_t flags;
+    /* For UPLOAD_BO_UPLOAD_RING, the ring position to release up to once the
+     * upload is done. */
+    ULONG ring_end;
 };
 
 struct wined3d_adapter_ops
@@ -4217,6 +4241,11 @@ static inline void wined3d_resource_acquire(struct wined3d_resource *resource)
     InterlockedIncrement(&resource->access_count);
 }
 
+static inline void wined3d_resource_acquire_count(struct wined3d_resource *resource, unsigned int count)
+{
+    InterlockedExchangeAdd(&resource->access_count, count);
+}
+
 static inline void wined3d_resource_release(struct wined3d_resource *resource)
 {
     LONG refcount = InterlockedDecrement(&resource->access_count);
@@ -4835,6 +4864,25 @@ struct wined3d_device_context
     struct wined3d_state *state;
 };
 
+#define WINED3D_CS_UPLOAD_RING_SIZE 0x400000
+
+/* Staging memory for uploads from the client thread. Allocations are
+ * released in order, by the CS thread, once the corresponding upload has
+ * been executed. */
+struct wined3d_cs_upload_ring
+{
+    BYTE *data;
+    /* Free-running byte counters. "head" is only accessed by the client
+     * thread, "tail" is advanced by the CS thread. */
+    ULONG head;
+    LONG tail;
+    BOOL mapped;
+
+    ULONG64 uploaded_bytes;
+    unsigned int upload_count;
+    unsigned int stall_count;
+};
+
 struct wined3d_cs
 {
     struct wined3d_device_context c;
@@ -4848,6 +4896,7 @@ struct wined3d_cs
     struct wined3d_cs_queue queue[WINED3D_CS_QUEUE_COUNT];
     size_t data_size, start, end;
     void *data;
+    struct wined3d_cs_upload_ring upload_ring;
     struct list query_poll_list;
     BOOL queries_flushed;
 
@@ -5382,6 +5431,8 @@ struct wined3d_swapchain_ops
     void (*swapchain_frontbuffer_updated)(struct wined3d_swapchain *swapchain);
 };
 
+#define WINED3D_FRAME_TIME_SAMPLES 256
+
 struct wined3d_swapchain
 {
     LONG ref;
@@ -5401,6 +5452,11 @@ struct wined3d_swapchain
     unsigned int max_frame_latency;
 
     LONG prev_time, frames;   /* Performance tracking */
+    LONGLONG last_present_time;
+    unsigned int frame_time_count;
+    unsigned int frame_time_seed;
+    float frame_time_max;
+    float *frame_times;       /* In milliseconds, WINED3D_FRAME_TIME_SAMPLES entries. */
 
     struct wined3d_swapchain_state state;
     HWND win_handle;
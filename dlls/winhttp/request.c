@@ -122,42 +122,81 @@ static const WCHAR *attribute_table[] =
     NULL                            /* WINHTTP_QUERY_PASSPORT_CONFIG            = 78 */
 };
 
-static DWORD start_queue( struct queue *queue )
+/* Asynchronous tasks of an object run in order, one at a time, but on the
+ * process thread pool, so that idle requests don't keep a thread around. */
+struct task
 {
-    if (queue->pool) return ERROR_SUCCESS;
-
-    if (!(queue->pool = CreateThreadpool( NULL ))) return GetLastError();
-    SetThreadpoolThreadMinimum( queue->pool, 1 );
-    SetThreadpoolThreadMaximum( queue->pool, 1 );
-
-    memset( &queue->env, 0, sizeof(queue->env) );
-    queue->env.Version = 1;
-    queue->env.Pool = queue->pool;
+    struct list entry;
+    PTP_WORK_CALLBACK callback;
+    void *ctx;
+};
 
-    TRACE("started %p\n", queue);
-    return ERROR_SUCCESS;
+void init_queue( struct queue *queue, struct object_header *obj )
+{
+    InitializeSRWLock( &queue->lock );
+    list_init( &queue->tasks );
+    queue->obj = obj;
+    queue->running = FALSE;
 }
 
-void stop_queue( struct queue *queue )
+static void CALLBACK run_queue( TP_CALLBACK_INSTANCE *instance, void *ctx, TP_WORK *work )
 {
-    if (!queue->pool) return;
-    CloseThreadpool( queue->pool );
-    queue->pool = NULL;
-    TRACE("stopped %p\n", queue);
+    struct queue *queue = ctx;
+    struct object_header *obj = queue->obj;
+    struct task *task;
+    struct list *entry;
+
+    for (;;)
+    {
+        AcquireSRWLockExclusive( &queue->lock );
+        if (!(entry = list_head( &queue->tasks )))
+        {
+            queue->running = FALSE;
+            ReleaseSRWLockExclusive( &queue->lock );
+            break;
+        }
+        list_remove( entry );
+        ReleaseSRWLockExclusive( &queue->lock );
+
+        task = LIST_ENTRY( entry, struct task, entry );
+        task->callback( instance, task->ctx, work );
+        free( task );
+    }
+
+    /* the queue may be freed along with its object */
+    release_object( obj );
 }
 
-static DWORD queue_task( struct queue *queue, PTP_WORK_CALLBACK task, void *ctx )
+static DWORD queue_task( struct queue *queue, PTP_WORK_CALLBACK callback, void *ctx )
 {
-    TP_WORK *work;
-    DWORD ret;
+    struct task *task;
+    TP_WORK *work = NULL;
 
-    if ((ret = start_queue( queue ))) return ret;
+    if (!(task = malloc( sizeof(*task) ))) return ERROR_OUTOFMEMORY;
+    task->callback = callback;
+    task->ctx = ctx;
 
-    if (!(work = CreateThreadpoolWork( task, ctx, &queue->env ))) return GetLastError();
-    TRACE("queueing %p in %p\n", work, queue);
-    SubmitThreadpoolWork( work );
-    CloseThreadpoolWork( work );
+    AcquireSRWLockExclusive( &queue->lock );
+    if (!queue->running)
+    {
+        if (!(work = CreateThreadpoolWork( run_queue, queue, NULL )))
+        {
+            ReleaseSRWLockExclusive( &queue->lock );
+            free( task );
+            return GetLastError();
+        }
+        addref_object( queue->obj );
+        queue->running = TRUE;
+    }
+    TRACE("queueing %p in %p\n", task, queue);
+    list_add_tail( &queue->tasks, &task->entry );
+    ReleaseSRWLockExclusive( &queue->lock );
 
+    if (work)
+    {
+        SubmitThreadpoolWork( work );
+        CloseThreadpoolWork( work );
+    }
     return ERROR_SUCCESS;
 }
 
@@ -1379,12 +1418,21 @@ static void CALLBACK connection_collector( TP_CALLBACK_INSTANCE *instance, void
     FreeLibraryWhenCallbackReturns( instance, winhttp_instance );
 }
 
-static void cache_connection( struct netconn *netconn )
+static void cache_connection( struct netconn *netconn, DWORD max_conns )
 {
+    struct netconn *oldest = NULL;
+
     TRACE( "caching connection %p\n", netconn );
 
     EnterCriticalSection( &connection_pool_cs );
 
+    /* keep at most max_conns idle connections per host, dropping the least recently used one */
+    if (list_count( &netconn->host->connections ) >= max_conns)
+    {
+        oldest = LIST_ENTRY( list_tail( &netconn->host->connections ), struct netconn, entry );
+        list_remove( &oldest->entry );
+    }
+
     netconn->keep_until = GetTickCount64() + DEFAULT_KEEP_ALIVE_TIMEOUT;
     list_add_head( &netconn->host->connections, &netconn->entry );
 
@@ -1399,6 +1447,12 @@ static void cache_connection( struct netconn *netconn )
     }
 
     LeaveCriticalSection( &connection_pool_cs );
+
+    if (oldest)
+    {
+        TRACE( "too many idle connections, closing %p\n", oldest );
+        netconn_close( oldest );
+    }
 }
 
 static DWORD map_secure_protocols( DWORD mask )
@@ -1801,7 +1855,14 @@ static void finished_reading( struct request *request )
     if (close)
         netconn_close( request->netconn );
     else
-        cache_connection( request->netconn );
+    {
+        struct session *session = request->connect->session;
+
+        if (!wcscmp( request->version, L"HTTP/1.0" ))
+            cache_connection( request->netconn, session->max_conns_per_1_0_server );
+        else
+            cache_connection( request->netconn, session->max_conns_per_server );
+    }
     request->netconn = NULL;
 }
 
@@ -1821,23 +1882,61 @@ static BOOL end_of_read_data( struct request *request )
     return (request->content_length == request->content_read);
 }
 
+/* return the size of data that can be read directly into the caller's buffer,
+ * bypassing the read buffer; this is only worth it for large reads */
+static DWORD get_direct_read_size( struct request *request, DWORD size )
+{
+    if (request->read_size || size < sizeof(request->read_buf)) return 0;
+    if (request->read_chunked)
+    {
+        if (request->read_chunked_size == ~0u) return 0;
+        return min( size, request->read_chunked_size );
+    }
+    if (request->content_length == ~0u) return size;
+    return min( size, request->content_length - request->content_read );
+}
+
+static DWORD read_direct( struct request *request, char *buffer, DWORD size, int *read, BOOL notify )
+{
+    DWORD ret;
+
+    if (notify) send_callback( &request->hdr, WINHTTP_CALLBACK_STATUS_RECEIVING_RESPONSE, NULL, 0 );
+
+    ret = netconn_recv( request->netconn, buffer, size, 0, read );
+
+    if (notify) send_callback( &request->hdr, WINHTTP_CALLBACK_STATUS_RESPONSE_RECEIVED, read, sizeof(*read) );
+    return ret;
+}
+
 static DWORD read_data( struct request *request, void *buffer, DWORD size, DWORD *read, BOOL async )
 {
     int count, bytes_read = 0;
-    DWORD ret = ERROR_SUCCESS;
+    DWORD ret = ERROR_SUCCESS, direct;
 
     if (end_of_read_data( request )) goto done;
 
     while (size)
     {
-        if (!(count = get_available_data( request )))
+        if ((direct = get_direct_read_size( request, size )))
+        {
+            if ((ret = read_direct( request, (char *)buffer + bytes_read, direct, &count, async ))) goto done;
+            if (!count)
+            {
+                request->content_length = request->content_read = 0;
+                goto done;
+            }
+        }
+        else
         {
-            if ((ret = refill_buffer( request, async ))) goto done;
-            if (!(count = get_available_data( request ))) goto done;
+            if (!(count = get_available_data( request )))
+            {
+                if ((ret = refill_buffer( request, async ))) goto done;
+                if (!(count = get_available_data( request ))) goto done;
+            }
+            count = min( count, size );
+            memcpy( (char *)buffer + bytes_read, request->read_buf + request->read_pos, count );
+            remove_data( request, count );
         }
-        count = min( count, size );
-        memcpy( (char *)buffer + bytes_read, request->read_buf + request->read_pos, count );
-        remove_data( request, count );
         if (request->read_chunked) request->read_chunked_size -= count;
         size -= count;
         bytes_read += count;
@@ -3059,9 +3158,6 @@ static void socket_destroy( struct object_header *hdr )
 
     TRACE("%p\n", socket);
 
-    stop_queue( &socket->send_q );
-    stop_queue( &socket->recv_q );
-
     release_object( &socket->request->hdr );
     free( socket );
 }
@@ -3110,6 +3206,8 @@ HINTERNET WINAPI WinHttpWebSocketCompleteUpgrade( HINTERNET hrequest, DWORD_PTR
     socket->hdr.callback = request->hdr.callback;
     socket->hdr.notify_mask = request->hdr.notify_mask;
     socket->hdr.context = context;
+    init_queue( &socket->send_q, &socket->hdr );
+    init_queue( &socket->recv_q, &socket->hdr );
 
     addref_object( &request->hdr );
     socket->request = request;
@@ -3556,7 +3654,6 @@ static DWORD socket_shutdown( struct socket *socket, USHORT status, const void *
 {
     DWORD ret;
 
-    stop_queue( &socket->send_q );
     if (!(ret = send_frame( socket, SOCKET_OPCODE_CLOSE, status, reason, len, TRUE )))
     {
         socket->state = SOCKET_STATE_SHUTDOWN;
@@ -3639,7 +3736,6 @@ static DWORD socket_close( struct socket *socket, USHORT status, const void *rea
 
     if (socket->state < SOCKET_STATE_SHUTDOWN)
     {
-        stop_queue( &socket->send_q );
         if ((ret = send_frame( socket, SOCKET_OPCODE_CLOSE, status, reason, len, TRUE ))) goto done;
         socket->state = SOCKET_STATE_SHUTDOWN;
     }
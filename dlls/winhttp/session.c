@@ -43,6 +43,7 @@ WINE_DEFAULT_DEBUG_CHANNEL(winhttp);
 #define DEFAULT_SEND_TIMEOUT                30000
 #define DEFAULT_RECEIVE_TIMEOUT             30000
 #define DEFAULT_RECEIVE_RESPONSE_TIMEOUT    ~0u
+#define DEFAULT_MAX_CONNS_PER_SERVER        ~0u
 
 void send_callback( struct object_header *hdr, DWORD status, void *info, DWORD buflen )
 {
@@ -144,6 +145,20 @@ static BOOL session_query_option( struct object_header *hdr, DWORD option, void
         *buflen = sizeof(DWORD);
         return TRUE;
 
+    case WINHTTP_OPTION_MAX_CONNS_PER_SERVER:
+        if (!validate_buffer( buffer, buflen, sizeof(DWORD) )) return FALSE;
+
+        *(DWORD *)buffer = session->max_conns_per_server;
+        *buflen = sizeof(DWORD);
+        return TRUE;
+
+    case WINHTTP_OPTION_MAX_CONNS_PER_1_0_SERVER:
+        if (!validate_buffer( buffer, buflen, sizeof(DWORD) )) return FALSE;
+
+        *(DWORD *)buffer = session->max_conns_per_1_0_server;
+        *buflen = sizeof(DWORD);
+        return TRUE;
+
     default:
         FIXME("unimplemented option %u\n", option);
         SetLastError( ERROR_INVALID_PARAMETER );
@@ -226,11 +241,23 @@ static BOOL session_set_option( struct object_header *hdr, DWORD option, void *b
         return TRUE;
 
     case WINHTTP_OPTION_MAX_CONNS_PER_SERVER:
-        FIXME("WINHTTP_OPTION_MAX_CONNS_PER_SERVER: %d\n", *(DWORD *)buffer);
+        if (!*(DWORD *)buffer)
+        {
+            SetLastError( ERROR_INVALID_PARAMETER );
+            return FALSE;
+        }
+        TRACE("WINHTTP_OPTION_MAX_CONNS_PER_SERVER: %u\n", *(DWORD *)buffer);
+        session->max_conns_per_server = *(DWORD *)buffer;
         return TRUE;
 
     case WINHTTP_OPTION_MAX_CONNS_PER_1_0_SERVER:
-        FIXME("WINHTTP_OPTION_MAX_CONNS_PER_1_0_SERVER: %d\n", *(DWORD *)buffer);
+        if (!*(DWORD *)buffer)
+        {
+            SetLastError( ERROR_INVALID_PARAMETER );
+            return FALSE;
+        }
+        TRACE("WINHTTP_OPTION_MAX_CONNS_PER_1_0_SERVER: %u\n", *(DWORD *)buffer);
+        session->max_conns_per_1_0_server = *(DWORD *)buffer;
         return TRUE;
 
     default:
@@ -269,6 +296,8 @@ HINTERNET WINAPI WinHttpOpen( LPCWSTR agent, DWORD access, LPCWSTR proxy, LPCWST
     session->send_timeout = DEFAULT_SEND_TIMEOUT;
     session->receive_timeout = DEFAULT_RECEIVE_TIMEOUT;
     session->receive_response_timeout = DEFAULT_RECEIVE_RESPONSE_TIMEOUT;
+    session->max_conns_per_server = DEFAULT_MAX_CONNS_PER_SERVER;
+    session->max_conns_per_1_0_server = DEFAULT_MAX_CONNS_PER_SERVER;
     list_init( &session->cookie_cache );
     InitializeCriticalSection( &session->cs );
     session->cs.DebugInfo->Spare[0] = (DWORD_PTR)(__FILE__ ": session.cs");
@@ -598,7 +627,6 @@ static void request_destroy( struct object_header *hdr )
 
     TRACE("%p\n", request);
 
-    stop_queue( &request->queue );
     release_object( &request->connect->hdr );
 
     if (request->cred_handle_initialized) FreeCredentialsHandle( &request->cred_handle );
@@ -1160,6 +1188,7 @@ HINTERNET WINAPI WinHttpOpenRequest( HINTERNET hconnect, LPCWSTR verb, LPCWSTR o
     request->hdr.notify_mask = connect->hdr.notify_mask;
     request->hdr.context = connect->hdr.context;
     request->hdr.redirect_policy = connect->hdr.redirect_policy;
+    init_queue( &request->queue, &request->hdr );
 
     addref_object( &connect->hdr );
     request->connect = connect;
@@ -109,6 +109,16 @@ static void test_WinHttpQueryOption(void)
     ok(feature == WINHTTP_OPTION_REDIRECT_POLICY_DISALLOW_HTTPS_TO_HTTP,
        "expected WINHTTP_OPTION_REDIRECT_POLICY_DISALLOW_HTTPS_TO_HTTP, got %#x\n", feature);
 
+    feature = 4;
+    ret = WinHttpSetOption(session, WINHTTP_OPTION_MAX_CONNS_PER_SERVER, &feature, sizeof(feature));
+    ok(ret, "failed to set option %u\n", GetLastError());
+    feature = 0xdeadbeef;
+    size = sizeof(feature);
+    ret = WinHttpQueryOption(session, WINHTTP_OPTION_MAX_CONNS_PER_SERVER, &feature, &size);
+    ok(ret, "failed to query option %u\n", GetLastError());
+    ok(size == sizeof(feature), "got size %u\n", size);
+    ok(feature == 4, "got %u\n", feature);
+
     SetLastError(0xdeadbeef);
     ret = WinHttpSetOption(session, WINHTTP_OPTION_REDIRECT_POLICY, NULL, sizeof(feature));
     ok(!ret, "should fail to set redirect policy %u\n", GetLastError());
@@ -3626,6 +3636,48 @@ static void test_multiple_reads(int port)
     WinHttpCloseHandle(ses);
 }
 
+static void test_large_reads(int port)
+{
+    HINTERNET ses, con, req;
+    DWORD i, total_len = 0, bytes_read;
+    char *buf;
+    BOOL ret;
+
+    ses = WinHttpOpen(L"winetest", WINHTTP_ACCESS_TYPE_NO_PROXY, NULL, NULL, 0);
+    ok(ses != NULL, "failed to open session %u\n", GetLastError());
+
+    con = WinHttpConnect(ses, L"localhost", port, 0);
+    ok(con != NULL, "failed to open a connection %u\n", GetLastError());
+
+    req = WinHttpOpenRequest(con, NULL, L"big", NULL, NULL, NULL, 0);
+    ok(req != NULL, "failed to open a request %u\n", GetLastError());
+
+    ret = WinHttpSendRequest(req, NULL, 0, NULL, 0, 0, 0);
+    ok(ret, "failed to send request %u\n", GetLastError());
+
+    ret = WinHttpReceiveResponse(req, NULL);
+    ok(ret == TRUE, "expected success\n");
+
+    /* read with a buffer larger than the whole body */
+    buf = HeapAlloc( GetProcessHeap(), 0, 0x10000 );
+    for (;;)
+    {
+        bytes_read = 0xdeadbeef;
+        ret = WinHttpReadData( req, buf + total_len, 0x10000 - total_len, &bytes_read );
+        ok(ret, "WinHttpReadData failed: %u.\n", GetLastError());
+        if (!ret || !bytes_read) break;
+        total_len += bytes_read;
+    }
+    ok(total_len == BIG_BUFFER_LEN, "got wrong length: 0x%x\n", total_len);
+    for (i = 0; i < total_len; i++) if (buf[i] != 'm') break;
+    ok(i == total_len, "got %#x at %u\n", buf[i], i);
+    HeapFree( GetProcessHeap(), 0, buf );
+
+    WinHttpCloseHandle(req);
+    WinHttpCloseHandle(con);
+    WinHttpCloseHandle(ses);
+}
+
 static void test_cookies( int port )
 {
     HINTERNET ses, con, req;
@@ -5580,6 +5632,7 @@ START_TEST (winhttp)
     test_large_data_authentication(si.port);
     test_bad_header(si.port);
     test_multiple_reads(si.port);
+    test_large_reads(si.port);
     test_cookies(si.port);
     test_request_path_escapes(si.port);
     test_passport_auth(si.port);
@@ -82,6 +82,8 @@ struct session
     HANDLE unload_event;
     DWORD secure_protocols;
     DWORD passport_flags;
+    DWORD max_conns_per_server;
+    DWORD max_conns_per_1_0_server;
 };
 
 struct connect
@@ -157,8 +159,10 @@ struct authinfo
 
 struct queue
 {
-    TP_POOL *pool;
-    TP_CALLBACK_ENVIRON env;
+    SRWLOCK lock;
+    struct list tasks;
+    struct object_header *obj;  /* object the queue belongs to */
+    BOOL running;               /* a thread pool callback is processing the tasks */
 };
 
 enum request_flags
@@ -319,7 +323,7 @@ BOOL free_handle( HINTERNET ) DECLSPEC_HIDDEN;
 
 void send_callback( struct object_header *, DWORD, LPVOID, DWORD ) DECLSPEC_HIDDEN;
 void close_connection( struct request * ) DECLSPEC_HIDDEN;
-void stop_queue( struct queue * ) DECLSPEC_HIDDEN;
+void init_queue( struct queue *, struct object_header * ) DECLSPEC_HIDDEN;
 
 void netconn_close( struct netconn * ) DECLSPEC_HIDDEN;
 DWORD netconn_create( struct hostdata *, const struct sockaddr_storage *, int, struct netconn ** ) DECLSPEC_HIDDEN;
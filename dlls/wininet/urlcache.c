@@ -185,6 +185,7 @@ typedef struct
     char *cache_prefix; /* string that has to be prefixed for this container to be used */
     LPWSTR path; /* path to url container directory */
     HANDLE mapping; /* handle of file mapping */
+    urlcache_header *header; /* view of the mapping, kept between calls */
     DWORD file_size; /* size of file when mapping was opened */
     HANDLE mutex; /* handle of mutex */
     DWORD default_entry_type;
@@ -673,6 +674,9 @@ static DWORD cache_container_open_index(cache_container *container, DWORD blocks
  */
 static void cache_container_close_index(cache_container *pContainer)
 {
+    if (pContainer->header)
+        UnmapViewOfFile(pContainer->header);
+    pContainer->header = NULL;
     CloseHandle(pContainer->mapping);
     pContainer->mapping = NULL;
 }
@@ -689,6 +693,7 @@ static BOOL cache_containers_add(const char *cache_prefix, LPCWSTR path,
     }
 
     pContainer->mapping = NULL;
+    pContainer->header = NULL;
     pContainer->file_size = 0;
     pContainer->default_entry_type = default_entry_type;
 
@@ -884,29 +889,30 @@ static BOOL cache_containers_enum(char *search_pattern, DWORD index, cache_conta
 static urlcache_header* cache_container_lock_index(cache_container *pContainer)
 {
     BYTE index;
-    LPVOID pIndexData;
     urlcache_header* pHeader;
     DWORD error;
 
     /* acquire mutex */
     WaitForSingleObject(pContainer->mutex, INFINITE);
 
-    pIndexData = MapViewOfFile(pContainer->mapping, FILE_MAP_WRITE, 0, 0, 0);
+    /* The view is kept mapped between calls, mapping the whole index on every
+     * call is expensive. */
+    if (!pContainer->header)
+        pContainer->header = MapViewOfFile(pContainer->mapping, FILE_MAP_WRITE, 0, 0, 0);
 
-    if (!pIndexData)
+    if (!pContainer->header)
     {
         ReleaseMutex(pContainer->mutex);
         ERR("Couldn't MapViewOfFile. Error: %d\n", GetLastError());
         return NULL;
     }
-    pHeader = (urlcache_header*)pIndexData;
+    pHeader = pContainer->header;
 
     /* file has grown - we need to remap to prevent us getting
      * access violations when we try and access beyond the end
      * of the memory mapped file */
     if (pHeader->size != pContainer->file_size)
     {
-        UnmapViewOfFile( pHeader );
         cache_container_close_index(pContainer);
         error = cache_container_open_index(pContainer, MIN_BLOCK_NO);
         if (error != ERROR_SUCCESS)
@@ -915,15 +921,15 @@ static urlcache_header* cache_container_lock_index(cache_container *pContainer)
             SetLastError(error);
             return NULL;
         }
-        pIndexData = MapViewOfFile(pContainer->mapping, FILE_MAP_WRITE, 0, 0, 0);
+        pContainer->header = MapViewOfFile(pContainer->mapping, FILE_MAP_WRITE, 0, 0, 0);
 
-        if (!pIndexData)
+        if (!pContainer->header)
         {
             ReleaseMutex(pContainer->mutex);
             ERR("Couldn't MapViewOfFile. Error: %d\n", GetLastError());
             return NULL;
         }
-        pHeader = (urlcache_header*)pIndexData;
+        pHeader = pContainer->header;
     }
 
     TRACE("Signature: %s, file size: %d bytes\n", pHeader->signature, pHeader->size);
@@ -942,9 +948,12 @@ static urlcache_header* cache_container_lock_index(cache_container *pContainer)
  */
 static BOOL cache_container_unlock_index(cache_container *pContainer, urlcache_header *pHeader)
 {
+    /* a view that was replaced while the index was locked is released here */
+    if (pHeader != pContainer->header)
+        UnmapViewOfFile(pHeader);
+
     /* release mutex */
-    ReleaseMutex(pContainer->mutex);
-    return UnmapViewOfFile(pHeader);
+    return ReleaseMutex(pContainer->mutex);
 }
 
 /***********************************************************************
@@ -1173,16 +1182,18 @@ static DWORD cache_container_clean_index(cache_container *container, urlcache_he
         return ERROR_NOT_ENOUGH_MEMORY;
     }
 
+    /* keep the old view mapped until the new one is ready, the caller still uses it on failure */
+    container->header = NULL;
     cache_container_close_index(container);
     ret = cache_container_open_index(container, header->capacity_in_blocks*2);
     if(ret != ERROR_SUCCESS)
         return ret;
-    header = MapViewOfFile(container->mapping, FILE_MAP_WRITE, 0, 0, 0);
-    if(!header)
+    container->header = MapViewOfFile(container->mapping, FILE_MAP_WRITE, 0, 0, 0);
+    if(!container->header)
         return GetLastError();
 
     UnmapViewOfFile(*file_view);
-    *file_view = header;
+    *file_view = container->header;
     return ERROR_SUCCESS;
 }
 
@@ -3812,7 +3823,9 @@ BOOL WINAPI GetUrlCacheConfigInfoW(LPINTERNET_CACHE_CONFIG_INFOW info, LPDWORD s
     info->dwCacheSize = container->file_size / 1024;
     lstrcpynW(info->CachePath, container->path, MAX_PATH);
 
+    WaitForSingleObject(container->mutex, INFINITE);
     cache_container_close_index(container);
+    ReleaseMutex(container->mutex);
 
     TRACE("CachePath %s\n", debugstr_w(info->CachePath));
 
@@ -23,6 +23,7 @@
  */
 
 #include "ws2_32_private.h"
+#include "wine/list.h"
 
 WINE_DEFAULT_DEBUG_CHANNEL(winsock);
 WINE_DECLARE_DEBUG_CHANNEL(winediag);
@@ -47,26 +48,205 @@ static char *get_fqdn(void)
     return ret;
 }
 
+/* The host resolver doesn't tell us how long its answers are valid for, so
+ * keep them for a short fixed time, and unknown names for even less. */
+#define ADDRINFO_CACHE_SIZE         64
+#define ADDRINFO_CACHE_TTL          10000
+#define ADDRINFO_CACHE_NEGATIVE_TTL 2000
+
+struct addrinfo_cache_entry
+{
+    struct list entry;
+    char *node;
+    char *service;
+    BOOL has_hints;
+    struct addrinfo hints;
+    int ret;
+    struct addrinfo *info;
+    unsigned int size;
+    ULONGLONG expires;
+};
+
+/* Most recently used entries first. */
+static struct list addrinfo_cache = LIST_INIT( addrinfo_cache );
+static unsigned int addrinfo_cache_count, addrinfo_cache_hits, addrinfo_cache_misses;
+DECLARE_CRITICAL_SECTION(cs_addrinfo_cache);
+
+/* The result of getaddrinfo is a single block, with all pointers inside it. */
+static struct addrinfo *copy_addrinfo( const struct addrinfo *info, unsigned int size )
+{
+    struct addrinfo *ret, *ai;
+    ptrdiff_t offset;
+
+    if (!(ret = malloc( size ))) return NULL;
+    memcpy( ret, info, size );
+    offset = (char *)ret - (char *)info;
+
+    for (ai = ret; ai; ai = ai->ai_next)
+    {
+        if (ai->ai_canonname) ai->ai_canonname += offset;
+        if (ai->ai_addr) ai->ai_addr = (struct sockaddr *)((char *)ai->ai_addr + offset);
+        if (ai->ai_next) ai->ai_next = (struct addrinfo *)((char *)ai->ai_next + offset);
+    }
+    return ret;
+}
+
+static BOOL addrinfo_cache_matches( const struct addrinfo_cache_entry *entry, const char *node,
+                                    const char *service, const struct addrinfo *hints )
+{
+    if (_stricmp( entry->node, node )) return FALSE;
+    if (!entry->service != !service || (service && strcmp( entry->service, service ))) return FALSE;
+    if (entry->has_hints != !!hints) return FALSE;
+    return !hints || (entry->hints.ai_flags == hints->ai_flags && entry->hints.ai_family == hints->ai_family
+                      && entry->hints.ai_socktype == hints->ai_socktype
+                      && entry->hints.ai_protocol == hints->ai_protocol);
+}
+
+static void free_addrinfo_cache_entry( struct addrinfo_cache_entry *entry )
+{
+    list_remove( &entry->entry );
+    --addrinfo_cache_count;
+    free( entry->node );
+    free( entry->service );
+    free( entry->info );
+    free( entry );
+}
+
+static struct addrinfo_cache_entry *find_addrinfo_cache_entry( const char *node, const char *service,
+                                                               const struct addrinfo *hints, ULONGLONG now )
+{
+    struct addrinfo_cache_entry *entry, *next;
+
+    LIST_FOR_EACH_ENTRY_SAFE( entry, next, &addrinfo_cache, struct addrinfo_cache_entry, entry )
+    {
+        if (entry->expires <= now)
+            free_addrinfo_cache_entry( entry );
+        else if (addrinfo_cache_matches( entry, node, service, hints ))
+            return entry;
+    }
+    return NULL;
+}
+
+static BOOL get_cached_addrinfo( const char *node, const char *service,
+                                 const struct addrinfo *hints, struct addrinfo **info, int *ret )
+{
+    struct addrinfo_cache_entry *entry;
+    BOOL found = FALSE;
+
+    EnterCriticalSection( &cs_addrinfo_cache );
+
+    if ((entry = find_addrinfo_cache_entry( node, service, hints, GetTickCount64() )))
+    {
+        *info = NULL;
+        if ((*ret = entry->ret) || (*info = copy_addrinfo( entry->info, entry->size )))
+        {
+            list_remove( &entry->entry );
+            list_add_head( &addrinfo_cache, &entry->entry );
+            found = TRUE;
+        }
+    }
+
+    if (found) addrinfo_cache_hits++;
+    else addrinfo_cache_misses++;
+
+    LeaveCriticalSection( &cs_addrinfo_cache );
+    return found;
+}
+
+static void cache_addrinfo( const char *node, const char *service, const struct addrinfo *hints,
+                            const struct addrinfo *info, unsigned int size, int ret )
+{
+    struct addrinfo_cache_entry *entry, *old;
+    ULONGLONG now = GetTickCount64();
+
+    if (!(entry = calloc( 1, sizeof(*entry) ))) return;
+    if (!(entry->node = strdup( node ))) goto error;
+    if (service && !(entry->service = strdup( service ))) goto error;
+    if (info && !(entry->info = copy_addrinfo( info, size ))) goto error;
+    if ((entry->has_hints = !!hints))
+    {
+        entry->hints.ai_flags    = hints->ai_flags;
+        entry->hints.ai_family   = hints->ai_family;
+        entry->hints.ai_socktype = hints->ai_socktype;
+        entry->hints.ai_protocol = hints->ai_protocol;
+    }
+    entry->ret = ret;
+    entry->size = size;
+    entry->expires = now + (ret ? ADDRINFO_CACHE_NEGATIVE_TTL : ADDRINFO_CACHE_TTL);
+
+    EnterCriticalSection( &cs_addrinfo_cache );
+
+    if ((old = find_addrinfo_cache_entry( node, service, hints, now )))
+        free_addrinfo_cache_entry( old );
+    if (addrinfo_cache_count >= ADDRINFO_CACHE_SIZE)
+        free_addrinfo_cache_entry( LIST_ENTRY( list_tail( &addrinfo_cache ), struct addrinfo_cache_entry, entry ) );
+    list_add_head( &addrinfo_cache, &entry->entry );
+    ++addrinfo_cache_count;
+
+    LeaveCriticalSection( &cs_addrinfo_cache );
+    return;
+
+error:
+    free( entry->node );
+    free( entry->service );
+    free( entry );
+}
+
+void flush_addrinfo_cache(void)
+{
+    struct addrinfo_cache_entry *entry, *next;
+
+    TRACE( "getaddrinfo cache: %u hits, %u misses, %u entries\n",
+           addrinfo_cache_hits, addrinfo_cache_misses, addrinfo_cache_count );
+
+    EnterCriticalSection( &cs_addrinfo_cache );
+    LIST_FOR_EACH_ENTRY_SAFE( entry, next, &addrinfo_cache, struct addrinfo_cache_entry, entry )
+        free_addrinfo_cache_entry( entry );
+    LeaveCriticalSection( &cs_addrinfo_cache );
+}
+
+/* Numeric addresses are resolved without a lookup, whether or not the caller
+ * passes AI_NUMERICHOST, so there is nothing to gain from caching them. */
+static BOOL is_numeric_host( const char *node )
+{
+    const char *terminator;
+    IN6_ADDR addr6;
+    IN_ADDR addr4;
+    ULONG scope;
+    USHORT port;
+
+    if (!RtlIpv4StringToAddressA( node, FALSE, &terminator, &addr4 ) && !*terminator) return TRUE;
+    return !RtlIpv6StringToAddressExA( node, &addr6, &scope, &port );
+}
+
 /* call Unix getaddrinfo, allocating a large enough buffer */
 static int do_getaddrinfo( const char *node, const char *service,
                            const struct addrinfo *hints, struct addrinfo **info )
 {
     unsigned int size = 1024;
     struct getaddrinfo_params params = { node, service, hints, NULL, &size };
+    BOOL use_cache = node && (!hints || !(hints->ai_flags & AI_NUMERICHOST)) && !is_numeric_host( node );
     int ret;
 
+    if (use_cache && get_cached_addrinfo( node, service, hints, info, &ret ))
+        return ret;
+
     for (;;)
     {
         if (!(params.info = malloc( size )))
             return WSA_NOT_ENOUGH_MEMORY;
         if (!(ret = WS_CALL( getaddrinfo, &params )))
         {
+            if (use_cache) cache_addrinfo( node, service, hints, params.info, size, ret );
             *info = params.info;
             return ret;
         }
         free( params.info );
-        if (ret != ERROR_INSUFFICIENT_BUFFER) return ret;
+        if (ret != ERROR_INSUFFICIENT_BUFFER) break;
     }
+
+    if (use_cache && ret == WSAHOST_NOT_FOUND) cache_addrinfo( node, service, hints, NULL, 0, ret );
+    return ret;
 }
 
 
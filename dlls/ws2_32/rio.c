@@ -0,0 +1,704 @@
+/*
+ * Registered I/O extensions
+ *
+ * Copyright 2026 agent
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "ws2_32_private.h"
+#include "wine/list.h"
+
+WINE_DEFAULT_DEBUG_CHANNEL(winsock);
+
+/* Registered I/O requests are implemented as overlapped socket requests. Each
+ * request signals its own event, with the low bit set so that nothing is
+ * posted to a completion port the application may have bound the socket to,
+ * and a thread pool wait moves the result to the application's completion
+ * queue.
+ *
+ * Locks are taken in the order cs_rio, rio_rq.cs, rio_cq.cs. */
+
+struct rio_buffer
+{
+    char *data;
+    DWORD size;
+};
+
+struct rio_cq
+{
+    CRITICAL_SECTION cs;
+    RIORESULT *results;
+    ULONG size;         /* number of results the queue can hold */
+    ULONG reserved;     /* number of results reserved by request queues */
+    ULONG head;         /* index of the oldest queued result */
+    ULONG count;        /* number of queued results */
+    BOOL corrupt;       /* the queue overflowed */
+    BOOL armed;         /* RIONotify() was called and the notification is not yet delivered */
+    RIO_NOTIFICATION_COMPLETION notify;
+};
+
+struct rio_rq;
+
+struct rio_request
+{
+    OVERLAPPED ovl;
+    HANDLE event;
+    TP_WAIT *wait;
+    struct rio_rq *rq;
+    struct rio_request *next_free;
+    ULONGLONG context;
+    BOOL send;
+    BOOL notify;
+    WSABUF buf;
+    DWORD flags;
+    int addr_len;
+};
+
+struct rio_rq
+{
+    struct list entry;
+    LONG refcount;      /* one reference for the socket, and one per pending request */
+    BOOL closed;        /* the socket was closed */
+    SOCKET socket;
+    ULONGLONG context;
+    CRITICAL_SECTION cs;
+    struct rio_cq *recv_cq;
+    struct rio_cq *send_cq;
+    ULONG max_recv;
+    ULONG max_send;
+    ULONG pending_recv;
+    ULONG pending_send;
+    struct rio_request *free_requests;
+};
+
+DECLARE_CRITICAL_SECTION(cs_rio);
+
+static struct list rio_request_queues = LIST_INIT( rio_request_queues );
+
+static inline struct rio_cq *impl_from_RIO_CQ( RIO_CQ cq )
+{
+    return (struct rio_cq *)cq;
+}
+
+static inline struct rio_rq *impl_from_RIO_RQ( RIO_RQ rq )
+{
+    return (struct rio_rq *)rq;
+}
+
+static char *rio_get_buffer( const RIO_BUF *buf )
+{
+    const struct rio_buffer *buffer = (const struct rio_buffer *)buf->BufferId;
+
+    if (!buffer || buf->BufferId == RIO_INVALID_BUFFERID)
+        return NULL;
+    if (buf->Offset > buffer->size || buffer->size - buf->Offset < buf->Length)
+        return NULL;
+    return buffer->data + buf->Offset;
+}
+
+static void rio_signal( const RIO_NOTIFICATION_COMPLETION *notify )
+{
+    if (notify->Type == RIO_EVENT_COMPLETION)
+        SetEvent( notify->u.Event.EventHandle );
+    else
+        PostQueuedCompletionStatus( notify->u.Iocp.IocpHandle, 0, (ULONG_PTR)notify->u.Iocp.CompletionKey,
+                                    notify->u.Iocp.Overlapped );
+}
+
+static void rio_cq_add_result( struct rio_cq *cq, const RIORESULT *result, BOOL notify )
+{
+    RIO_NOTIFICATION_COMPLETION signal;
+    BOOL armed = FALSE;
+
+    EnterCriticalSection( &cq->cs );
+    if (cq->count == cq->size)
+    {
+        WARN( "completion queue %p overflowed\n", cq );
+        cq->corrupt = TRUE;
+    }
+    else
+    {
+        cq->results[(cq->head + cq->count) % cq->size] = *result;
+        cq->count++;
+    }
+    if (notify && cq->armed)
+    {
+        cq->armed = FALSE;
+        signal = cq->notify;
+        armed = TRUE;
+    }
+    LeaveCriticalSection( &cq->cs );
+
+    if (armed) rio_signal( &signal );
+}
+
+static void rio_release_rq( struct rio_rq *rq )
+{
+    struct rio_request *req, *next;
+
+    if (InterlockedDecrement( &rq->refcount )) return;
+
+    EnterCriticalSection( &cs_rio );
+    list_remove( &rq->entry );
+    LeaveCriticalSection( &cs_rio );
+
+    for (req = rq->free_requests; req; req = next)
+    {
+        next = req->next_free;
+        CloseThreadpoolWait( req->wait );
+        CloseHandle( req->event );
+        free( req );
+    }
+    rq->cs.DebugInfo->Spare[0] = 0;
+    DeleteCriticalSection( &rq->cs );
+    free( rq );
+}
+
+/* must be called with rq->cs held */
+static void rio_put_request( struct rio_rq *rq, struct rio_request *req )
+{
+    if (req->send)
+        rq->pending_send--;
+    else
+        rq->pending_recv--;
+    req->next_free = rq->free_requests;
+    rq->free_requests = req;
+}
+
+static void rio_complete_request( struct rio_request *req )
+{
+    struct rio_rq *rq = req->rq;
+    BOOL notify = req->notify;
+    RIORESULT result;
+    struct rio_cq *cq;
+    DWORD size, flags;
+
+    result.Status = WSAGetOverlappedResult( rq->socket, &req->ovl, &size, FALSE, &flags ) ? 0 : GetLastError();
+    result.BytesTransferred = req->ovl.InternalHigh;
+    result.SocketContext = rq->context;
+    result.RequestContext = req->context;
+
+    TRACE( "request %p, status %d, size %u\n", req, result.Status, result.BytesTransferred );
+
+    EnterCriticalSection( &rq->cs );
+    cq = req->send ? rq->send_cq : rq->recv_cq;
+    rio_put_request( rq, req );
+    if (cq) rio_cq_add_result( cq, &result, notify );
+    LeaveCriticalSection( &rq->cs );
+
+    rio_release_rq( rq );
+}
+
+static void CALLBACK rio_wait_callback( TP_CALLBACK_INSTANCE *instance, void *context,
+                                        TP_WAIT *wait, TP_WAIT_RESULT result )
+{
+    rio_complete_request( context );
+}
+
+static struct rio_request *rio_alloc_request(void)
+{
+    struct rio_request *req;
+
+    if (!(req = calloc( 1, sizeof(*req) ))) return NULL;
+    if (!(req->event = CreateEventW( NULL, TRUE, FALSE, NULL ))) goto error;
+    if (!(req->wait = CreateThreadpoolWait( rio_wait_callback, req, NULL ))) goto error;
+    return req;
+
+error:
+    if (req->event) CloseHandle( req->event );
+    free( req );
+    return NULL;
+}
+
+static BOOL WINAPI rio_init_once( INIT_ONCE *once, void *param, void **context )
+{
+    HMODULE module;
+
+    /* thread pool callbacks may run for as long as requests are pending */
+    return GetModuleHandleExW( GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS | GET_MODULE_HANDLE_EX_FLAG_PIN,
+                               (const WCHAR *)rio_wait_callback, &module );
+}
+
+static BOOL rio_submit( RIO_RQ queue, BOOL send, const RIO_BUF *data, ULONG count,
+                        const RIO_BUF *addr, DWORD flags, void *context )
+{
+    struct rio_rq *rq = impl_from_RIO_RQ( queue );
+    struct rio_request *req;
+    char *ptr = NULL, *addr_ptr = NULL;
+    DWORD size, err;
+    int ret;
+
+    if (!rq || count > 1 || (count && !data)
+            || (flags & ~(RIO_MSG_DONT_NOTIFY | RIO_MSG_DEFER | RIO_MSG_WAITALL | RIO_MSG_COMMIT_ONLY))
+            || (send && (flags & RIO_MSG_WAITALL)))
+    {
+        SetLastError( WSAEINVAL );
+        return FALSE;
+    }
+
+    /* requests are never deferred, so there is nothing to commit */
+    if ((flags & RIO_MSG_COMMIT_ONLY) && !count)
+        return TRUE;
+
+    if ((count && !(ptr = rio_get_buffer( data ))) || (addr && !(addr_ptr = rio_get_buffer( addr ))))
+    {
+        SetLastError( WSAEINVAL );
+        return FALSE;
+    }
+
+    EnterCriticalSection( &rq->cs );
+    if (rq->closed || (send ? rq->pending_send >= rq->max_send : rq->pending_recv >= rq->max_recv))
+        req = NULL;
+    else if ((req = rq->free_requests))
+        rq->free_requests = req->next_free;
+    else
+        req = rio_alloc_request();
+    if (req)
+    {
+        if (send)
+            rq->pending_send++;
+        else
+            rq->pending_recv++;
+    }
+    LeaveCriticalSection( &rq->cs );
+
+    if (!req)
+    {
+        SetLastError( rq->closed ? WSAENOTSOCK : WSAENOBUFS );
+        return FALSE;
+    }
+
+    memset( &req->ovl, 0, sizeof(req->ovl) );
+    ResetEvent( req->event );
+    req->ovl.hEvent = (HANDLE)((ULONG_PTR)req->event | 1);
+    req->rq = rq;
+    req->context = (ULONG_PTR)context;
+    req->send = send;
+    req->notify = !(flags & RIO_MSG_DONT_NOTIFY);
+    req->buf.buf = ptr;
+    req->buf.len = count ? data->Length : 0;
+    req->flags = (flags & RIO_MSG_WAITALL) ? MSG_WAITALL : 0;
+    req->addr_len = addr ? addr->Length : 0;
+
+    InterlockedIncrement( &rq->refcount );
+
+    if (send && addr)
+        ret = WSASendTo( rq->socket, &req->buf, 1, &size, 0, (struct sockaddr *)addr_ptr,
+                         req->addr_len, &req->ovl, NULL );
+    else if (send)
+        ret = WSASend( rq->socket, &req->buf, 1, &size, 0, &req->ovl, NULL );
+    else if (addr)
+        ret = WSARecvFrom( rq->socket, &req->buf, 1, &size, &req->flags, (struct sockaddr *)addr_ptr,
+                           &req->addr_len, &req->ovl, NULL );
+    else
+        ret = WSARecv( rq->socket, &req->buf, 1, &size, &req->flags, &req->ovl, NULL );
+
+    if (ret && (err = WSAGetLastError()) != WSA_IO_PENDING)
+    {
+        EnterCriticalSection( &rq->cs );
+        rio_put_request( rq, req );
+        LeaveCriticalSection( &rq->cs );
+        rio_release_rq( rq );
+        SetLastError( err );
+        return FALSE;
+    }
+
+    /* the event is also signaled when the request completes immediately */
+    SetThreadpoolWait( req->wait, req->event, NULL );
+    return TRUE;
+}
+
+static BOOL WINAPI RIOReceive( RIO_RQ queue, RIO_BUF *data, ULONG count, DWORD flags, void *context )
+{
+    TRACE( "queue %p, data %p, count %u, flags %#x, context %p\n", queue, data, count, flags, context );
+
+    return rio_submit( queue, FALSE, data, count, NULL, flags, context );
+}
+
+static int WINAPI RIOReceiveEx( RIO_RQ queue, RIO_BUF *data, ULONG count, RIO_BUF *local_addr,
+                                RIO_BUF *remote_addr, RIO_BUF *control, RIO_BUF *msg_flags,
+                                DWORD flags, void *context )
+{
+    TRACE( "queue %p, data %p, count %u, local_addr %p, remote_addr %p, control %p, msg_flags %p, flags %#x, context %p\n",
+           queue, data, count, local_addr, remote_addr, control, msg_flags, flags, context );
+
+    if (local_addr || control || msg_flags)
+        FIXME( "local address, control and flags buffers are not supported\n" );
+
+    return rio_submit( queue, FALSE, data, count, remote_addr, flags, context );
+}
+
+static BOOL WINAPI RIOSend( RIO_RQ queue, RIO_BUF *data, ULONG count, DWORD flags, void *context )
+{
+    TRACE( "queue %p, data %p, count %u, flags %#x, context %p\n", queue, data, count, flags, context );
+
+    return rio_submit( queue, TRUE, data, count, NULL, flags, context );
+}
+
+static BOOL WINAPI RIOSendEx( RIO_RQ queue, RIO_BUF *data, ULONG count, RIO_BUF *local_addr,
+                              RIO_BUF *remote_addr, RIO_BUF *control, RIO_BUF *msg_flags,
+                              DWORD flags, void *context )
+{
+    TRACE( "queue %p, data %p, count %u, local_addr %p, remote_addr %p, control %p, msg_flags %p, flags %#x, context %p\n",
+           queue, data, count, local_addr, remote_addr, control, msg_flags, flags, context );
+
+    if (local_addr || control || msg_flags)
+        FIXME( "local address, control and flags buffers are not supported\n" );
+
+    return rio_submit( queue, TRUE, data, count, remote_addr, flags, context );
+}
+
+static RIO_CQ WINAPI RIOCreateCompletionQueue( DWORD size, RIO_NOTIFICATION_COMPLETION *notify )
+{
+    struct rio_cq *cq;
+
+    TRACE( "size %u, notify %p\n", size, notify );
+
+    if (!size || size > RIO_MAX_CQ_SIZE
+            || (notify && notify->Type != RIO_EVENT_COMPLETION && notify->Type != RIO_IOCP_COMPLETION))
+    {
+        SetLastError( WSAEINVAL );
+        return RIO_INVALID_CQ;
+    }
+
+    if (!(cq = calloc( 1, sizeof(*cq) )) || !(cq->results = malloc( size * sizeof(*cq->results) )))
+    {
+        free( cq );
+        SetLastError( WSAENOBUFS );
+        return RIO_INVALID_CQ;
+    }
+
+    InitializeCriticalSection( &cq->cs );
+    cq->cs.DebugInfo->Spare[0] = (DWORD_PTR)(__FILE__ ": rio_cq.cs");
+    cq->size = size;
+    if (notify) cq->notify = *notify;
+    return (RIO_CQ)cq;
+}
+
+static void WINAPI RIOCloseCompletionQueue( RIO_CQ queue )
+{
+    struct rio_cq *cq = impl_from_RIO_CQ( queue );
+    struct rio_rq *rq;
+
+    TRACE( "queue %p\n", queue );
+
+    if (!cq) return;
+
+    EnterCriticalSection( &cs_rio );
+    LIST_FOR_EACH_ENTRY( rq, &rio_request_queues, struct rio_rq, entry )
+    {
+        EnterCriticalSection( &rq->cs );
+        if (rq->recv_cq == cq) rq->recv_cq = NULL;
+        if (rq->send_cq == cq) rq->send_cq = NULL;
+        LeaveCriticalSection( &rq->cs );
+    }
+    LeaveCriticalSection( &cs_rio );
+
+    cq->cs.DebugInfo->Spare[0] = 0;
+    DeleteCriticalSection( &cq->cs );
+    free( cq->results );
+    free( cq );
+}
+
+static BOOL WINAPI RIOResizeCompletionQueue( RIO_CQ queue, DWORD size )
+{
+    struct rio_cq *cq = impl_from_RIO_CQ( queue );
+    RIORESULT *results;
+    BOOL ret = FALSE;
+    ULONG i;
+
+    TRACE( "queue %p, size %u\n", queue, size );
+
+    if (!cq || !size || size > RIO_MAX_CQ_SIZE)
+    {
+        SetLastError( WSAEINVAL );
+        return FALSE;
+    }
+
+    if (!(results = malloc( size * sizeof(*results) )))
+    {
+        SetLastError( WSAENOBUFS );
+        return FALSE;
+    }
+
+    EnterCriticalSection( &cs_rio );
+    EnterCriticalSection( &cq->cs );
+    if (size >= cq->count && size >= cq->reserved)
+    {
+        for (i = 0; i < cq->count; ++i)
+            results[i] = cq->results[(cq->head + i) % cq->size];
+        free( cq->results );
+        cq->results = results;
+        cq->size = size;
+        cq->head = 0;
+        ret = TRUE;
+    }
+    LeaveCriticalSection( &cq->cs );
+    LeaveCriticalSection( &cs_rio );
+
+    if (!ret)
+    {
+        free( results );
+        SetLastError( WSAETOOMANYREFS );
+    }
+    return ret;
+}
+
+static ULONG WINAPI RIODequeueCompletion( RIO_CQ queue, RIORESULT *results, ULONG size )
+{
+    struct rio_cq *cq = impl_from_RIO_CQ( queue );
+    ULONG i, count;
+
+    TRACE( "queue %p, results %p, size %u\n", queue, results, size );
+
+    if (!cq || !results)
+    {
+        SetLastError( WSAEINVAL );
+        return RIO_CORRUPT_CQ;
+    }
+
+    EnterCriticalSection( &cq->cs );
+    if (cq->corrupt)
+        count = RIO_CORRUPT_CQ;
+    else
+    {
+        count = min( size, cq->count );
+        for (i = 0; i < count; ++i)
+            results[i] = cq->results[(cq->head + i) % cq->size];
+        cq->head = (cq->head + count) % cq->size;
+        cq->count -= count;
+    }
+    LeaveCriticalSection( &cq->cs );
+
+    return count;
+}
+
+static int WINAPI RIONotify( RIO_CQ queue )
+{
+    struct rio_cq *cq = impl_from_RIO_CQ( queue );
+    RIO_NOTIFICATION_COMPLETION signal;
+    BOOL signaled = FALSE;
+    int ret = 0;
+
+    TRACE( "queue %p\n", queue );
+
+    if (!cq || !cq->notify.Type)
+        return WSAEINVAL;
+
+    EnterCriticalSection( &cq->cs );
+    if (cq->armed)
+        ret = WSAEALREADY;
+    else
+    {
+        if (cq->notify.Type == RIO_EVENT_COMPLETION && cq->notify.u.Event.NotifyReset)
+            ResetEvent( cq->notify.u.Event.EventHandle );
+        if (cq->count)
+        {
+            signal = cq->notify;
+            signaled = TRUE;
+        }
+        else
+            cq->armed = TRUE;
+    }
+    LeaveCriticalSection( &cq->cs );
+
+    if (signaled) rio_signal( &signal );
+    return ret;
+}
+
+static RIO_RQ WINAPI RIOCreateRequestQueue( SOCKET socket, ULONG max_recv, ULONG max_recv_buffers,
+                                            ULONG max_send, ULONG max_send_buffers, RIO_CQ recv_queue,
+                                            RIO_CQ send_queue, void *context )
+{
+    static INIT_ONCE init_once = INIT_ONCE_STATIC_INIT;
+    struct rio_cq *recv_cq = impl_from_RIO_CQ( recv_queue ), *send_cq = impl_from_RIO_CQ( send_queue );
+    struct rio_rq *rq;
+    BOOL fits;
+
+    TRACE( "socket %#lx, max_recv %u, max_recv_buffers %u, max_send %u, max_send_buffers %u, "
+           "recv_queue %p, send_queue %p, context %p\n", socket, max_recv, max_recv_buffers,
+           max_send, max_send_buffers, recv_queue, send_queue, context );
+
+    if (!recv_cq || !send_cq || max_recv_buffers > 1 || max_send_buffers > 1
+            || max_recv > RIO_MAX_CQ_SIZE || max_send > RIO_MAX_CQ_SIZE)
+    {
+        SetLastError( WSAEINVAL );
+        return RIO_INVALID_RQ;
+    }
+
+    if (!InitOnceExecuteOnce( &init_once, rio_init_once, NULL, NULL ))
+    {
+        SetLastError( WSAENOBUFS );
+        return RIO_INVALID_RQ;
+    }
+
+    if (!(rq = calloc( 1, sizeof(*rq) )))
+    {
+        SetLastError( WSAENOBUFS );
+        return RIO_INVALID_RQ;
+    }
+
+    InitializeCriticalSection( &rq->cs );
+    rq->cs.DebugInfo->Spare[0] = (DWORD_PTR)(__FILE__ ": rio_rq.cs");
+    rq->refcount = 1;
+    rq->socket = socket;
+    rq->context = (ULONG_PTR)context;
+    rq->recv_cq = recv_cq;
+    rq->send_cq = send_cq;
+    rq->max_recv = max_recv;
+    rq->max_send = max_send;
+
+    /* make sure that every pending request has room in its completion queue */
+    EnterCriticalSection( &cs_rio );
+    if (recv_cq == send_cq)
+        fits = recv_cq->reserved + max_recv + max_send <= recv_cq->size;
+    else
+        fits = recv_cq->reserved + max_recv <= recv_cq->size && send_cq->reserved + max_send <= send_cq->size;
+    if (fits)
+    {
+        recv_cq->reserved += max_recv;
+        send_cq->reserved += max_send;
+        list_add_tail( &rio_request_queues, &rq->entry );
+    }
+    LeaveCriticalSection( &cs_rio );
+
+    if (!fits)
+    {
+        SetLastError( WSAENOBUFS );
+        goto error;
+    }
+
+    return (RIO_RQ)rq;
+
+error:
+    rq->cs.DebugInfo->Spare[0] = 0;
+    DeleteCriticalSection( &rq->cs );
+    free( rq );
+    return RIO_INVALID_RQ;
+}
+
+static BOOL WINAPI RIOResizeRequestQueue( RIO_RQ queue, DWORD max_recv, DWORD max_send )
+{
+    struct rio_rq *rq = impl_from_RIO_RQ( queue );
+    struct rio_cq *recv_cq, *send_cq;
+    ULONGLONG recv_reserved, send_reserved;
+    BOOL fits = FALSE;
+
+    TRACE( "queue %p, max_recv %u, max_send %u\n", queue, max_recv, max_send );
+
+    if (!rq || max_recv > RIO_MAX_CQ_SIZE || max_send > RIO_MAX_CQ_SIZE)
+    {
+        SetLastError( WSAEINVAL );
+        return FALSE;
+    }
+
+    EnterCriticalSection( &cs_rio );
+    EnterCriticalSection( &rq->cs );
+    recv_cq = rq->recv_cq;
+    send_cq = rq->send_cq;
+    if (!rq->closed && recv_cq && send_cq && max_recv >= rq->pending_recv && max_send >= rq->pending_send)
+    {
+        recv_reserved = (ULONGLONG)recv_cq->reserved - rq->max_recv + max_recv;
+        send_reserved = (ULONGLONG)send_cq->reserved - rq->max_send + max_send;
+        if (recv_cq == send_cq)
+            fits = recv_reserved - rq->max_send + max_send <= recv_cq->size;
+        else
+            fits = recv_reserved <= recv_cq->size && send_reserved <= send_cq->size;
+    }
+    if (fits)
+    {
+        recv_cq->reserved = recv_cq->reserved - rq->max_recv + max_recv;
+        send_cq->reserved = send_cq->reserved - rq->max_send + max_send;
+        rq->max_recv = max_recv;
+        rq->max_send = max_send;
+    }
+    LeaveCriticalSection( &rq->cs );
+    LeaveCriticalSection( &cs_rio );
+
+    if (!fits) SetLastError( WSAENOBUFS );
+    return fits;
+}
+
+static RIO_BUFFERID WINAPI RIORegisterBuffer( char *data, DWORD size )
+{
+    struct rio_buffer *buffer;
+
+    TRACE( "data %p, size %u\n", data, size );
+
+    if (!data || !size)
+    {
+        SetLastError( WSAEINVAL );
+        return RIO_INVALID_BUFFERID;
+    }
+
+    if (!(buffer = malloc( sizeof(*buffer) )))
+    {
+        SetLastError( WSAENOBUFS );
+        return RIO_INVALID_BUFFERID;
+    }
+    buffer->data = data;
+    buffer->size = size;
+    return (RIO_BUFFERID)buffer;
+}
+
+static void WINAPI RIODeregisterBuffer( RIO_BUFFERID id )
+{
+    TRACE( "id %p\n", id );
+
+    if (id != RIO_INVALID_BUFFERID) free( id );
+}
+
+/* called when the socket is closed; request queues have no other way to be freed */
+void rio_close_socket( SOCKET socket )
+{
+    struct rio_rq *rq, *found = NULL;
+
+    EnterCriticalSection( &cs_rio );
+    LIST_FOR_EACH_ENTRY( rq, &rio_request_queues, struct rio_rq, entry )
+    {
+        if (rq->closed || rq->socket != socket) continue;
+
+        EnterCriticalSection( &rq->cs );
+        if (rq->recv_cq) rq->recv_cq->reserved -= rq->max_recv;
+        if (rq->send_cq) rq->send_cq->reserved -= rq->max_send;
+        rq->closed = TRUE;
+        LeaveCriticalSection( &rq->cs );
+        found = rq;
+        break;
+    }
+    LeaveCriticalSection( &cs_rio );
+
+    /* pending requests keep the queue alive until they are cancelled */
+    if (found) rio_release_rq( found );
+}
+
+void rio_get_function_table( RIO_EXTENSION_FUNCTION_TABLE *table )
+{
+    table->cbSize                   = sizeof(*table);
+    table->RIOReceive               = RIOReceive;
+    table->RIOReceiveEx             = RIOReceiveEx;
+    table->RIOSend                  = RIOSend;
+    table->RIOSendEx                = RIOSendEx;
+    table->RIOCloseCompletionQueue  = RIOCloseCompletionQueue;
+    table->RIOCreateCompletionQueue = RIOCreateCompletionQueue;
+    table->RIOCreateRequestQueue    = RIOCreateRequestQueue;
+    table->RIODequeueCompletion     = RIODequeueCompletion;
+    table->RIODeregisterBuffer      = RIODeregisterBuffer;
+    table->RIONotify                = RIONotify;
+    table->RIORegisterBuffer        = RIORegisterBuffer;
+    table->RIOResizeCompletionQueue = RIOResizeCompletionQueue;
+    table->RIOResizeRequestQueue    = RIOResizeRequestQueue;
+}
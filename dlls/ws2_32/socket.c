@@ -560,6 +560,11 @@ BOOL WINAPI DllMain( HINSTANCE instance, DWORD reason, void *reserved )
         return !NtQueryVirtualMemory( GetCurrentProcess(), instance, MemoryWineUnixFuncs,
                                       &ws_unix_handle, sizeof(ws_unix_handle), NULL );
 
+    case DLL_PROCESS_DETACH:
+        if (reserved) break;
+        flush_addrinfo_cache();
+        break;
+
     case DLL_THREAD_DETACH:
         free_per_thread_data();
     }
@@ -1162,6 +1167,7 @@ int WINAPI closesocket( SOCKET s )
         return -1;
     }
 
+    rio_close_socket( s );
     CloseHandle( (HANDLE)s );
     return 0;
 }
@@ -1807,6 +1813,7 @@ static const char *debugstr_wsaioctl(DWORD code)
         IOCTL_NAME(SIO_FLUSH);
         IOCTL_NAME(SIO_GET_BROADCAST_ADDRESS);
         IOCTL_NAME(SIO_GET_EXTENSION_FUNCTION_POINTER);
+        IOCTL_NAME(SIO_GET_MULTIPLE_EXTENSION_FUNCTION_POINTER);
         IOCTL_NAME(SIO_GET_GROUP_QOS);
         IOCTL_NAME(SIO_GET_INTERFACE_LIST);
         /* IOCTL_NAME(SIO_GET_INTERFACE_LIST_EX); */
@@ -2140,6 +2147,36 @@ INT WINAPI WSAIoctl(SOCKET s, DWORD code, LPVOID in_buff, DWORD in_size, LPVOID
         return -1;
     }
 
+    case SIO_GET_MULTIPLE_EXTENSION_FUNCTION_POINTER:
+    {
+        static const GUID rio_guid = WSAID_MULTIPLE_RIO;
+        NTSTATUS status = STATUS_SUCCESS;
+        DWORD ret;
+
+        if (!in_buff || in_size < sizeof(GUID) || !IsEqualGUID( &rio_guid, in_buff ))
+        {
+            FIXME( "SIO_GET_MULTIPLE_EXTENSION_FUNCTION_POINTER %s: stub\n",
+                   in_buff && in_size >= sizeof(GUID) ? debugstr_guid(in_buff) : "(null)" );
+            SetLastError( WSAEINVAL );
+            return -1;
+        }
+
+        if (!out_buff || out_size < sizeof(RIO_EXTENSION_FUNCTION_TABLE))
+        {
+            SetLastError( WSAEFAULT );
+            return -1;
+        }
+
+        TRACE( "returning registered I/O function table\n" );
+        rio_get_function_table( out_buff );
+
+        ret = server_ioctl_sock( s, IOCTL_AFD_WINE_COMPLETE_ASYNC, &status, sizeof(status),
+                                 NULL, 0, ret_size, overlapped, completion );
+        *ret_size = sizeof(RIO_EXTENSION_FUNCTION_TABLE);
+        SetLastError( ret );
+        return ret ? -1 : 0;
+    }
+
     case SIO_KEEPALIVE_VALS:
     {
         DWORD ret;
@@ -3327,7 +3364,7 @@ SOCKET WINAPI WSASocketW(int af, int type, int protocol,
     RtlInitUnicodeString(&string, L"\\Device\\Afd");
     InitializeObjectAttributes(&attr, &string, (flags & WSA_FLAG_NO_HANDLE_INHERIT) ? 0 : OBJ_INHERIT, NULL, NULL);
     if ((status = NtOpenFile(&handle, GENERIC_READ | GENERIC_WRITE | SYNCHRONIZE, &attr,
-            &io, 0, (flags & WSA_FLAG_OVERLAPPED) ? 0 : FILE_SYNCHRONOUS_IO_NONALERT)))
+            &io, 0, (flags & (WSA_FLAG_OVERLAPPED | WSA_FLAG_REGISTERED_IO)) ? 0 : FILE_SYNCHRONOUS_IO_NONALERT)))
     {
         WARN("Failed to create socket, status %#x.\n", status);
         WSASetLastError(NtStatusToWSAError(status));
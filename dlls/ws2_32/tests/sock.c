@@ -2361,6 +2361,75 @@ static void test_UDP(void)
     }
 }
 
+static void test_UDP_pending_recv(void)
+{
+    struct sockaddr_in addr = {0};
+    OVERLAPPED overlapped[16];
+    char buffers[16][8];
+    SOCKET server, client;
+    unsigned int i, round;
+    DWORD size, flags;
+    WSABUF wsabuf;
+    int len, ret;
+
+    server = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    client = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    ret = bind(server, (struct sockaddr *)&addr, sizeof(addr));
+    ok(!ret, "failed to bind, error %u\n", WSAGetLastError());
+    len = sizeof(addr);
+    ret = getsockname(server, (struct sockaddr *)&addr, &len);
+    ok(!ret, "failed to get address, error %u\n", WSAGetLastError());
+
+    for (i = 0; i < ARRAY_SIZE(overlapped); ++i)
+        overlapped[i].hEvent = CreateEventW(NULL, TRUE, FALSE, NULL);
+
+    /* Several rounds, so that datagrams keep arriving while reads are pending. */
+    for (round = 0; round < 4; ++round)
+    {
+        for (i = 0; i < ARRAY_SIZE(overlapped); ++i)
+        {
+            ResetEvent(overlapped[i].hEvent);
+            memset(buffers[i], 0, sizeof(buffers[i]));
+            wsabuf.buf = buffers[i];
+            wsabuf.len = sizeof(buffers[i]);
+            flags = 0;
+            ret = WSARecv(server, &wsabuf, 1, NULL, &flags, &overlapped[i], NULL);
+            ok(ret == -1, "expected failure\n");
+            ok(WSAGetLastError() == ERROR_IO_PENDING, "got error %u\n", WSAGetLastError());
+        }
+
+        for (i = 0; i < ARRAY_SIZE(overlapped); ++i)
+        {
+            char data[8];
+
+            sprintf(data, "%u.%u", round, i);
+            ret = sendto(client, data, sizeof(data), 0, (struct sockaddr *)&addr, sizeof(addr));
+            ok(ret == sizeof(data), "got %d, error %u\n", ret, WSAGetLastError());
+        }
+
+        for (i = 0; i < ARRAY_SIZE(overlapped); ++i)
+        {
+            char expect[8];
+
+            ret = WaitForSingleObject(overlapped[i].hEvent, 1000);
+            ok(!ret, "%u.%u: wait timed out\n", round, i);
+            ret = GetOverlappedResult((HANDLE)server, &overlapped[i], &size, FALSE);
+            ok(ret, "%u.%u: got error %u\n", round, i, GetLastError());
+            ok(size == sizeof(expect), "%u.%u: got size %u\n", round, i, size);
+            sprintf(expect, "%u.%u", round, i);
+            ok(!strcmp(buffers[i], expect), "%u.%u: got %s\n", round, i, debugstr_a(buffers[i]));
+        }
+    }
+
+    for (i = 0; i < ARRAY_SIZE(overlapped); ++i)
+        CloseHandle(overlapped[i].hEvent);
+    closesocket(client);
+    closesocket(server);
+}
+
 static void test_WSASocket(void)
 {
     SOCKET sock = INVALID_SOCKET;
@@ -4682,6 +4751,169 @@ static void test_get_extension_func(void)
     closesocket(s);
 }
 
+static void test_rio(void)
+{
+    GUID rio_guid = WSAID_MULTIPLE_RIO;
+    RIO_EXTENSION_FUNCTION_TABLE rio = {sizeof(rio)};
+    RIO_NOTIFICATION_COMPLETION notify = {0};
+    struct sockaddr_in addr = {0};
+    char buffer[64], recv_buffer[64], data[] = "rio test";
+    OVERLAPPED overlapped, *overlapped_ptr;
+    RIO_BUFFERID buffer_id;
+    RIORESULT results[4];
+    SOCKET server, client;
+    DWORD size, flags;
+    HANDLE event, port;
+    WSABUF wsabuf;
+    ULONG_PTR key;
+    RIO_BUF buf;
+    RIO_CQ cq;
+    RIO_RQ rq;
+    int len, ret;
+
+    server = WSASocketA(AF_INET, SOCK_DGRAM, IPPROTO_UDP, NULL, 0, WSA_FLAG_REGISTERED_IO);
+    ok(server != INVALID_SOCKET, "failed to create socket, error %u\n", WSAGetLastError());
+
+    size = 0xdeadbeef;
+    ret = WSAIoctl(server, SIO_GET_MULTIPLE_EXTENSION_FUNCTION_POINTER, &rio_guid, sizeof(rio_guid),
+            &rio, sizeof(rio), &size, NULL, NULL);
+    if (ret)
+    {
+        win_skip("RIO is not supported, error %u\n", WSAGetLastError());
+        closesocket(server);
+        return;
+    }
+    ok(size == sizeof(rio), "got size %u\n", size);
+
+    WSASetLastError(0xdeadbeef);
+    ret = WSAIoctl(server, SIO_GET_MULTIPLE_EXTENSION_FUNCTION_POINTER, &rio_guid, sizeof(rio_guid),
+            &rio, sizeof(rio) - 1, &size, NULL, NULL);
+    ok(ret == -1, "expected failure\n");
+    ok(WSAGetLastError() == WSAEFAULT, "got error %u\n", WSAGetLastError());
+
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    ret = bind(server, (struct sockaddr *)&addr, sizeof(addr));
+    ok(!ret, "failed to bind, error %u\n", WSAGetLastError());
+    len = sizeof(addr);
+    ret = getsockname(server, (struct sockaddr *)&addr, &len);
+    ok(!ret, "failed to get address, error %u\n", WSAGetLastError());
+
+    event = CreateEventW(NULL, FALSE, FALSE, NULL);
+    notify.Type = RIO_EVENT_COMPLETION;
+    notify.Event.EventHandle = event;
+    notify.Event.NotifyReset = TRUE;
+    cq = rio.RIOCreateCompletionQueue(4, &notify);
+    ok(cq != RIO_INVALID_CQ, "failed to create completion queue, error %u\n", WSAGetLastError());
+
+    memset(buffer, 0, sizeof(buffer));
+    buffer_id = rio.RIORegisterBuffer(buffer, sizeof(buffer));
+    ok(buffer_id != RIO_INVALID_BUFFERID, "failed to register buffer, error %u\n", WSAGetLastError());
+
+    rq = rio.RIOCreateRequestQueue(server, 2, 1, 2, 1, cq, cq, (void *)0x1234);
+    ok(rq != RIO_INVALID_RQ, "failed to create request queue, error %u\n", WSAGetLastError());
+
+    ret = rio.RIODequeueCompletion(cq, results, ARRAY_SIZE(results));
+    ok(!ret, "got %u results\n", ret);
+
+    buf.BufferId = buffer_id;
+    buf.Offset = 8;
+    buf.Length = sizeof(buffer) - 8;
+    ret = rio.RIOReceive(rq, &buf, 1, 0, (void *)0x5678);
+    ok(ret, "failed to receive, error %u\n", WSAGetLastError());
+
+    ret = rio.RIONotify(cq);
+    ok(!ret, "got error %u\n", ret);
+
+    client = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    ret = sendto(client, data, sizeof(data), 0, (struct sockaddr *)&addr, sizeof(addr));
+    ok(ret == sizeof(data), "got %d, error %u\n", ret, WSAGetLastError());
+
+    ret = WaitForSingleObject(event, 1000);
+    ok(!ret, "wait timed out\n");
+
+    memset(results, 0xcc, sizeof(results));
+    ret = rio.RIODequeueCompletion(cq, results, ARRAY_SIZE(results));
+    ok(ret == 1, "got %u results\n", ret);
+    ok(!results[0].Status, "got status %#x\n", results[0].Status);
+    ok(results[0].BytesTransferred == sizeof(data), "got size %u\n", results[0].BytesTransferred);
+    ok(results[0].SocketContext == 0x1234, "got socket context %#I64x\n", results[0].SocketContext);
+    ok(results[0].RequestContext == 0x5678, "got request context %#I64x\n", results[0].RequestContext);
+    ok(!memcmp(buffer + 8, data, sizeof(data)), "got data %s\n", debugstr_a(buffer + 8));
+
+    ret = rio.RIODequeueCompletion(cq, results, ARRAY_SIZE(results));
+    ok(!ret, "got %u results\n", ret);
+
+    closesocket(client);
+    closesocket(server);
+
+    /* RIO requests and regular overlapped requests on a socket bound to the
+     * application's own completion port */
+    server = WSASocketA(AF_INET, SOCK_DGRAM, IPPROTO_UDP, NULL, 0, WSA_FLAG_OVERLAPPED | WSA_FLAG_REGISTERED_IO);
+    ok(server != INVALID_SOCKET, "failed to create socket, error %u\n", WSAGetLastError());
+    addr.sin_port = 0;
+    ret = bind(server, (struct sockaddr *)&addr, sizeof(addr));
+    ok(!ret, "failed to bind, error %u\n", WSAGetLastError());
+    len = sizeof(addr);
+    ret = getsockname(server, (struct sockaddr *)&addr, &len);
+    ok(!ret, "failed to get address, error %u\n", WSAGetLastError());
+
+    port = CreateIoCompletionPort((HANDLE)server, NULL, 0x77, 0);
+    ok(!!port, "failed to create port, error %u\n", GetLastError());
+
+    rq = rio.RIOCreateRequestQueue(server, 2, 1, 2, 1, cq, cq, (void *)0x1234);
+    ok(rq != RIO_INVALID_RQ, "failed to create request queue, error %u\n", WSAGetLastError());
+
+    memset(&overlapped, 0, sizeof(overlapped));
+    wsabuf.buf = recv_buffer;
+    wsabuf.len = sizeof(recv_buffer);
+    flags = 0;
+    ret = WSARecv(server, &wsabuf, 1, NULL, &flags, &overlapped, NULL);
+    ok(ret == -1, "expected failure\n");
+    ok(WSAGetLastError() == ERROR_IO_PENDING, "got error %u\n", WSAGetLastError());
+
+    ret = rio.RIOReceive(rq, &buf, 1, 0, (void *)0x5678);
+    ok(ret, "failed to receive, error %u\n", WSAGetLastError());
+    ret = rio.RIONotify(cq);
+    ok(!ret, "got error %u\n", ret);
+
+    client = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    ret = sendto(client, data, sizeof(data), 0, (struct sockaddr *)&addr, sizeof(addr));
+    ok(ret == sizeof(data), "got %d, error %u\n", ret, WSAGetLastError());
+    ret = sendto(client, data, sizeof(data), 0, (struct sockaddr *)&addr, sizeof(addr));
+    ok(ret == sizeof(data), "got %d, error %u\n", ret, WSAGetLastError());
+
+    overlapped_ptr = NULL;
+    ret = GetQueuedCompletionStatus(port, &size, &key, &overlapped_ptr, 1000);
+    ok(ret, "failed to get completion status, error %u\n", GetLastError());
+    ok(key == 0x77, "got key %#Ix\n", key);
+    ok(overlapped_ptr == &overlapped, "got overlapped %p\n", overlapped_ptr);
+    ok(size == sizeof(data), "got size %u\n", size);
+
+    ret = WaitForSingleObject(event, 1000);
+    ok(!ret, "wait timed out\n");
+    memset(results, 0xcc, sizeof(results));
+    ret = rio.RIODequeueCompletion(cq, results, ARRAY_SIZE(results));
+    ok(ret == 1, "got %u results\n", ret);
+    ok(!results[0].Status, "got status %#x\n", results[0].Status);
+    ok(results[0].BytesTransferred == sizeof(data), "got size %u\n", results[0].BytesTransferred);
+    ok(results[0].RequestContext == 0x5678, "got request context %#I64x\n", results[0].RequestContext);
+
+    /* the RIO request must not have posted anything to the application's port */
+    overlapped_ptr = (OVERLAPPED *)0xdeadbeef;
+    ret = GetQueuedCompletionStatus(port, &size, &key, &overlapped_ptr, 100);
+    ok(!ret, "expected failure\n");
+    ok(GetLastError() == WAIT_TIMEOUT, "got error %u\n", GetLastError());
+    ok(!overlapped_ptr, "got overlapped %p\n", overlapped_ptr);
+
+    closesocket(client);
+    closesocket(server);
+    CloseHandle(port);
+    rio.RIOCloseCompletionQueue(cq);
+    rio.RIODeregisterBuffer(buffer_id);
+    CloseHandle(event);
+}
+
 static void test_base_handle(void)
 {
     OVERLAPPED overlapped = {0}, *overlapped_ptr;
@@ -9451,6 +9683,99 @@ static void test_completion_port(void)
     CloseHandle(io_port);
 }
 
+/* Requests which can be satisfied immediately are done inline, before the
+ * server queues anything, but must still report their completion. */
+static void test_immediate_completion_port(void)
+{
+    char buf[16], data[] = "fast path";
+    OVERLAPPED ov, ov2, *olp;
+    SOCKET client, server;
+    DWORD size, flags;
+    ULONG_PTR key;
+    WSABUF wsabuf;
+    HANDLE port;
+    int ret;
+
+    tcp_socketpair(&client, &server);
+    port = CreateIoCompletionPort((HANDLE)server, NULL, 0x12, 0);
+    ok(!!port, "failed to create port, error %u\n", GetLastError());
+
+    ret = send(client, data, sizeof(data), 0);
+    ok(ret == sizeof(data), "got %d\n", ret);
+    Sleep(100);
+
+    memset(&ov, 0, sizeof(ov));
+    memset(buf, 0, sizeof(buf));
+    wsabuf.buf = buf;
+    wsabuf.len = sizeof(buf);
+    flags = 0;
+    size = 0xdeadbeef;
+    ret = WSARecv(server, &wsabuf, 1, &size, &flags, &ov, NULL);
+    ok(!ret, "got error %u\n", WSAGetLastError());
+    ok(size == sizeof(data), "got size %u\n", size);
+    ok(!strcmp(buf, data), "got data %s\n", debugstr_a(buf));
+
+    olp = NULL;
+    ret = GetQueuedCompletionStatus(port, &size, &key, &olp, 1000);
+    ok(ret, "failed to get completion, error %u\n", GetLastError());
+    ok(key == 0x12, "got key %#Ix\n", key);
+    ok(olp == &ov, "got overlapped %p\n", olp);
+    ok(size == sizeof(data), "got size %u\n", size);
+
+    memset(&ov, 0, sizeof(ov));
+    wsabuf.buf = data;
+    wsabuf.len = sizeof(data);
+    size = 0xdeadbeef;
+    ret = WSASend(server, &wsabuf, 1, &size, 0, &ov, NULL);
+    ok(!ret, "got error %u\n", WSAGetLastError());
+    ok(size == sizeof(data), "got size %u\n", size);
+
+    olp = NULL;
+    ret = GetQueuedCompletionStatus(port, &size, &key, &olp, 1000);
+    ok(ret, "failed to get completion, error %u\n", GetLastError());
+    ok(olp == &ov, "got overlapped %p\n", olp);
+    ok(size == sizeof(data), "got size %u\n", size);
+
+    ret = recv(client, buf, sizeof(buf), 0);
+    ok(ret == sizeof(data), "got %d\n", ret);
+
+    /* two pending receives are satisfied in the order they were queued */
+    memset(&ov, 0, sizeof(ov));
+    memset(&ov2, 0, sizeof(ov2));
+    wsabuf.buf = buf;
+    wsabuf.len = 4;
+    flags = 0;
+    ret = WSARecv(server, &wsabuf, 1, NULL, &flags, &ov, NULL);
+    ok(ret == -1, "expected failure\n");
+    ok(WSAGetLastError() == ERROR_IO_PENDING, "got error %u\n", WSAGetLastError());
+    wsabuf.buf = buf + 4;
+    wsabuf.len = sizeof(buf) - 4;
+    flags = 0;
+    ret = WSARecv(server, &wsabuf, 1, NULL, &flags, &ov2, NULL);
+    ok(ret == -1, "expected failure\n");
+    ok(WSAGetLastError() == ERROR_IO_PENDING, "got error %u\n", WSAGetLastError());
+
+    memset(buf, 0, sizeof(buf));
+    ret = send(client, data, sizeof(data), 0);
+    ok(ret == sizeof(data), "got %d\n", ret);
+
+    olp = NULL;
+    ret = GetQueuedCompletionStatus(port, &size, &key, &olp, 1000);
+    ok(ret, "failed to get completion, error %u\n", GetLastError());
+    ok(olp == &ov, "got overlapped %p\n", olp);
+    ok(size == 4, "got size %u\n", size);
+    olp = NULL;
+    ret = GetQueuedCompletionStatus(port, &size, &key, &olp, 1000);
+    ok(ret, "failed to get completion, error %u\n", GetLastError());
+    ok(olp == &ov2, "got overlapped %p\n", olp);
+    ok(size == sizeof(data) - 4, "got size %u\n", size);
+    ok(!strcmp(buf, data), "got data %s\n", debugstr_a(buf));
+
+    closesocket(client);
+    closesocket(server);
+    CloseHandle(port);
+}
+
 static void test_connect_completion_port(void)
 {
     OVERLAPPED overlapped = {0}, *overlapped_ptr;
@@ -11895,6 +12220,7 @@ START_TEST( sock )
         do_test(&tests[i]);
 
     test_UDP();
+    test_UDP_pending_recv();
 
     test_WSASocket();
     test_WSADuplicateSocket();
@@ -11911,6 +12237,7 @@ START_TEST( sock )
     test_fionbio();
     test_fionread_siocatmark();
     test_get_extension_func();
+    test_rio();
     test_get_interface_list();
     test_keepalive_vals();
     test_sioRoutingInterfaceQuery();
@@ -11935,6 +12262,7 @@ START_TEST( sock )
     test_DisconnectEx();
 
     test_completion_port();
+    test_immediate_completion_port();
     test_connect_completion_port();
     test_shutdown_completion_port();
     test_bind();
@@ -80,6 +80,11 @@ extern int num_startup;
 
 struct per_thread_data *get_per_thread_data(void) DECLSPEC_HIDDEN;
 
+void flush_addrinfo_cache(void) DECLSPEC_HIDDEN;
+
+void rio_close_socket( SOCKET socket ) DECLSPEC_HIDDEN;
+void rio_get_function_table( RIO_EXTENSION_FUNCTION_TABLE *table ) DECLSPEC_HIDDEN;
+
 struct getaddrinfo_params
 {
     const char *node;
@@ -57,6 +57,7 @@ struct async
     unsigned int         canceled :1;     /* have we already queued cancellation for this async? */
     unsigned int         unknown_status :1; /* initial status is not known yet */
     unsigned int         blocking :1;     /* async is blocking */
+    unsigned int         restarted :1;    /* async was alerted, but the client had nothing to do */
     struct completion   *completion;      /* completion associated with fd */
     apc_param_t          comp_key;        /* completion key associated with fd */
     unsigned int         comp_flags;      /* completion flags */
@@ -276,6 +277,7 @@ struct async *create_async( struct fd *fd, struct thread *thread, const async_da
     async->terminated    = 0;
     async->canceled      = 0;
     async->unknown_status = 0;
+    async->restarted     = 0;
     async->blocking      = !is_fd_overlapped( fd );
     async->completion    = fd_get_completion( fd, &async->comp_key );
     async->comp_flags    = 0;
@@ -464,6 +466,7 @@ void async_set_result( struct object *obj, unsigned int status, apc_param_t tota
     {
         async->terminated = 0;
         async->alerted = 0;
+        async->restarted = 1;
         async_reselect( async );
     }
     else
@@ -576,6 +579,34 @@ void async_wake_up( struct async_queue *queue, unsigned int status )
     }
 }
 
+/* alert up to max waiting asyncs, as long as they belong to the same thread as the
+ * first one, so that the client processes them in queue order; returns the number
+ * of asyncs alerted, and in idle how many of them were already alerted before
+ * without finding anything to do */
+unsigned int async_wake_up_batch( struct async_queue *queue, unsigned int max, unsigned int *idle )
+{
+    struct list *ptr, *next;
+    struct thread *thread = NULL;
+    unsigned int count = 0;
+
+    *idle = 0;
+    LIST_FOR_EACH_SAFE( ptr, next, &queue->queue )
+    {
+        struct async *async = LIST_ENTRY( ptr, struct async, queue_entry );
+
+        if (count == max) break;
+        if (async->terminated) continue;
+        if (!thread) thread = async->thread;
+        else if (async->thread != thread) break;
+
+        if (async->restarted) (*idle)++;
+        async->restarted = 0;
+        async_terminate( async, STATUS_ALERTED );
+        count++;
+    }
+    return count;
+}
+
 static void iosb_dump( struct object *obj, int verbose );
 static void iosb_destroy( struct object *obj );
 
@@ -105,6 +105,10 @@ typedef int (*non_overlap_func_t)( struct region *reg, const rectangle_t *r,
 
 static const rectangle_t empty_rect;  /* all-zero rectangle for empty regions */
 
+/* scratch buffer used by region_op, kept around to avoid an allocation for every operation */
+static rectangle_t *op_rects;
+static int op_size;
+
 /* add a rectangle to a region */
 static inline rectangle_t *add_rect( struct region *reg )
 {
@@ -206,7 +210,7 @@ static int coalesce_region( struct region *pReg, int prevStart, int curStart )
 
 /* apply an operation to two regions */
 /* check the GDI version of the code for explanations */
-static int region_op( struct region *newReg, const struct region *reg1, const struct region *reg2,
+static int region_op( struct region *dst, const struct region *reg1, const struct region *reg2,
                       overlap_func_t overlap_func,
                       non_overlap_func_t non_overlap1_func,
                       non_overlap_func_t non_overlap2_func )
@@ -219,15 +223,26 @@ static int region_op( struct region *newReg, const struct region *reg1, const st
     const rectangle_t *r1End = r1 + reg1->num_rects;
     const rectangle_t *r2End = r2 + reg2->num_rects;
 
-    rectangle_t *new_rects, *old_rects = newReg->rects;
+    struct region result, *newReg = &result;
+    rectangle_t *new_rects;
     int new_size, ret = 0;
 
+    /* build the result in the scratch buffer since dst may be one of the sources */
     new_size = max( reg1->num_rects, reg2->num_rects ) * 2;
-    if (!(new_rects = mem_alloc( new_size * sizeof(*newReg->rects) ))) return 0;
+    if (op_size < new_size)
+    {
+        if (!(new_rects = realloc( op_rects, new_size * sizeof(*op_rects) )))
+        {
+            set_error( STATUS_NO_MEMORY );
+            return 0;
+        }
+        op_rects = new_rects;
+        op_size = new_size;
+    }
 
-    newReg->size = new_size;
-    newReg->rects = new_rects;
-    newReg->num_rects = 0;
+    result.size = op_size;
+    result.rects = op_rects;
+    result.num_rects = 0;
 
     if (reg1->extents.top < reg2->extents.top)
         ybot = reg1->extents.top;
@@ -321,18 +336,24 @@ static int region_op( struct region *newReg, const struct region *reg1, const st
 
     if (newReg->num_rects != curBand) coalesce_region(newReg, prevBand, curBand);
 
-    if ((newReg->num_rects < (newReg->size / 2)) && (newReg->size > 2))
+    if (dst->size < newReg->num_rects)
     {
-        new_size = max( newReg->num_rects, RGN_DEFAULT_RECTS );
-        if ((new_rects = realloc( newReg->rects, sizeof(*newReg->rects) * new_size )))
-        {
-            newReg->rects = new_rects;
-            newReg->size = new_size;
-        }
+        /* give the scratch buffer to dst and keep its old one as scratch */
+        new_rects = dst->rects;
+        new_size = dst->size;
+        dst->rects = newReg->rects;
+        dst->size = newReg->size;
+        newReg->rects = new_rects;
+        newReg->size = new_size;
     }
+    else memcpy( dst->rects, newReg->rects, newReg->num_rects * sizeof(*dst->rects) );
+    dst->num_rects = newReg->num_rects;
     ret = 1;
+
 done:
-    free( old_rects );
+    /* add_rect may have grown the scratch buffer */
+    op_rects = result.rects;
+    op_size = result.size;
     return ret;
 }
 
@@ -838,15 +859,30 @@ struct region *xor_region( struct region *dst, const struct region *src1,
     return dst;
 }
 
+/* find the first rectangle of the first band that doesn't lie entirely above y */
+static const rectangle_t *find_band( const struct region *region, int y )
+{
+    int start = 0, end = region->num_rects;
+
+    /* band bottoms are sorted, so we can do a binary search */
+    while (start < end)
+    {
+        int i = (start + end) / 2;
+        if (region->rects[i].bottom <= y) start = i + 1;
+        else end = i;
+    }
+    return region->rects + start;
+}
+
 /* check if the given point is inside the region */
 int point_in_region( struct region *region, int x, int y )
 {
-    const rectangle_t *ptr, *end;
+    const rectangle_t *ptr, *end = region->rects + region->num_rects;
 
-    for (ptr = region->rects, end = region->rects + region->num_rects; ptr < end; ptr++)
+    if (!region->num_rects || !point_in_rect( &region->extents, x, y )) return 0;
+    for (ptr = find_band( region, y ); ptr < end; ptr++)
     {
         if (ptr->top > y) return 0;
-        if (ptr->bottom <= y) continue;
         /* now we are in the correct band */
         if (ptr->left > x) return 0;
         if (ptr->right <= x) continue;
@@ -858,12 +894,12 @@ int point_in_region( struct region *region, int x, int y )
 /* check if the given rectangle is (at least partially) inside the region */
 int rect_in_region( struct region *region, const rectangle_t *rect )
 {
-    const rectangle_t *ptr, *end;
+    const rectangle_t *ptr, *end = region->rects + region->num_rects;
 
-    for (ptr = region->rects, end = region->rects + region->num_rects; ptr < end; ptr++)
+    if (!region->num_rects || !EXTENTCHECK( &region->extents, rect )) return 0;
+    for (ptr = find_band( region, rect->top ); ptr < end; ptr++)
     {
         if (ptr->top >= rect->bottom) return 0;
-        if (ptr->bottom <= rect->top) continue;
         if (ptr->left >= rect->right) continue;
         if (ptr->right <= rect->left) continue;
         return 1;
@@ -120,6 +120,14 @@ union win_sockaddr
 
 static struct list poll_list = LIST_INIT( poll_list );
 
+struct poll_req_socket
+{
+    struct list entry;              /* entry in the socket's poll list */
+    struct poll_req *req;
+    struct sock *sock;
+    int flags;
+};
+
 struct poll_req
 {
     struct list entry;
@@ -129,11 +137,7 @@ struct poll_req
     int exclusive;
     unsigned int count;
     struct poll_socket_output *output;
-    struct
-    {
-        struct sock *sock;
-        int flags;
-    } sockets[1];
+    struct poll_req_socket sockets[1];
 };
 
 struct accept_req
@@ -205,12 +209,15 @@ struct sock
     struct accept_req  *accept_recv_req; /* pending accept-into request which will recv on this socket */
     struct connect_req *connect_req; /* pending connection request */
     struct poll_req    *main_poll;   /* main poll */
+    struct list         poll_list;   /* poll requests waiting on this socket */
     union win_sockaddr  addr;        /* socket name */
     int                 addr_len;    /* socket name length */
     unsigned int        rcvbuf;      /* advisory recv buffer size */
     unsigned int        sndbuf;      /* advisory send buffer size */
     unsigned int        rcvtimeo;    /* receive timeout in ms */
     unsigned int        sndtimeo;    /* send timeout in ms */
+    unsigned int        read_batch;  /* number of datagram reads to wake up at once */
+    timeout_t           read_time;   /* time of the last datagram read wakeup */
     unsigned int        rd_shutdown : 1; /* is the read end shut down? */
     unsigned int        wr_shutdown : 1; /* is the write end shut down? */
     unsigned int        wr_shutdown_pending : 1; /* is a write shutdown pending? */
@@ -789,7 +796,10 @@ static void free_poll_req( void *private )
     if (req->timeout) remove_timeout_user( req->timeout );
 
     for (i = 0; i < req->count; ++i)
+    {
+        list_remove( &req->sockets[i].entry );
         release_object( req->sockets[i].sock );
+    }
     release_object( req->async );
     release_object( req->iosb );
     list_remove( &req->entry );
@@ -855,29 +865,28 @@ static void complete_async_poll( struct poll_req *req, unsigned int status )
 static void complete_async_polls( struct sock *sock, int event, int error )
 {
     int flags = get_poll_flags( sock, event );
-    struct poll_req *req, *next;
+    struct poll_req_socket *entry;
 
-    LIST_FOR_EACH_ENTRY_SAFE( req, next, &poll_list, struct poll_req, entry )
+    /* completing a request may free it, along with its other entries in this
+     * list, so start over after each completion */
+restart:
+    LIST_FOR_EACH_ENTRY( entry, &sock->poll_list, struct poll_req_socket, entry )
     {
-        unsigned int i;
+        struct poll_req *req = entry->req;
+        unsigned int i = entry - req->sockets;
 
         if (req->iosb->status != STATUS_PENDING) continue;
+        if (!(entry->flags & flags)) continue;
 
-        for (i = 0; i < req->count; ++i)
-        {
-            if (req->sockets[i].sock != sock) continue;
-            if (!(req->sockets[i].flags & flags)) continue;
-
-            if (debug_level)
-                fprintf( stderr, "completing poll for socket %p, wanted %#x got %#x\n",
-                         sock, req->sockets[i].flags, flags );
+        if (debug_level)
+            fprintf( stderr, "completing poll for socket %p, wanted %#x got %#x\n",
+                     sock, entry->flags, flags );
 
-            req->output[i].flags = req->sockets[i].flags & flags;
-            req->output[i].status = sock_get_ntstatus( error );
+        req->output[i].flags = entry->flags & flags;
+        req->output[i].status = sock_get_ntstatus( error );
 
-            complete_async_poll( req, STATUS_SUCCESS );
-            break;
-        }
+        complete_async_poll( req, STATUS_SUCCESS );
+        goto restart;
     }
 }
 
@@ -892,6 +901,28 @@ static void async_poll_timeout( void *private )
     complete_async_poll( req, STATUS_TIMEOUT );
 }
 
+/* Waking up reads one at a time means that each datagram costs a full round
+ * trip between the server and the client before the next read is started.
+ * Each datagram fits into a single read, so when the socket keeps becoming
+ * readable again quickly, wake up several reads at once and let the client
+ * drain them back to back. Reads that were woken up for nothing shrink the
+ * batch again. */
+#define SOCK_MAX_READ_BATCH     16
+#define SOCK_READ_BATCH_PERIOD  1000  /* 100 us */
+
+static void sock_wake_up_datagram_reads( struct sock *sock )
+{
+    unsigned int count, idle;
+
+    count = async_wake_up_batch( &sock->read_q, sock->read_batch, &idle );
+
+    if (idle)
+        sock->read_batch = max( 1, sock->read_batch / 2 );
+    else if (count == sock->read_batch && current_time - sock->read_time < SOCK_READ_BATCH_PERIOD)
+        sock->read_batch = min( SOCK_MAX_READ_BATCH, sock->read_batch * 2 );
+    sock->read_time = current_time;
+}
+
 static int sock_dispatch_asyncs( struct sock *sock, int event, int error )
 {
     if (event & (POLLIN | POLLPRI))
@@ -917,7 +948,10 @@ static int sock_dispatch_asyncs( struct sock *sock, int event, int error )
     if (event & (POLLIN | POLLPRI) && async_waiting( &sock->read_q ))
     {
         if (debug_level) fprintf( stderr, "activating read queue for socket %p\n", sock );
-        async_wake_up( &sock->read_q, STATUS_ALERTED );
+        if (sock->type == WS_SOCK_DGRAM)
+            sock_wake_up_datagram_reads( sock );
+        else
+            async_wake_up( &sock->read_q, STATUS_ALERTED );
         event &= ~(POLLIN | POLLPRI);
     }
 
@@ -1135,7 +1169,7 @@ static int sock_get_poll_events( struct fd *fd )
 {
     struct sock *sock = get_fd_user( fd );
     unsigned int mask = sock->mask & ~sock->reported_events;
-    struct poll_req *req;
+    struct poll_req_socket *entry;
     int ev = 0;
 
     assert( sock->obj.ops == &sock_ops );
@@ -1216,17 +1250,8 @@ static int sock_get_poll_events( struct fd *fd )
         break;
     }
 
-    LIST_FOR_EACH_ENTRY( req, &poll_list, struct poll_req, entry )
-    {
-        unsigned int i;
-
-        for (i = 0; i < req->count; ++i)
-        {
-            if (req->sockets[i].sock != sock) continue;
-
-            ev |= poll_flags_from_afd( sock, req->sockets[i].flags );
-        }
-    }
+    LIST_FOR_EACH_ENTRY( entry, &sock->poll_list, struct poll_req_socket, entry )
+        ev |= poll_flags_from_afd( sock, entry->flags );
 
     return ev;
 }
@@ -1333,7 +1358,7 @@ static int sock_close_handle( struct object *obj, struct process *process, obj_h
     if (sock->obj.handle_count == 1) /* last handle */
     {
         struct accept_req *accept_req, *accept_next;
-        struct poll_req *poll_req, *poll_next;
+        struct poll_req_socket *entry;
 
         if (sock->accept_recv_req)
             async_terminate( sock->accept_recv_req->async, STATUS_CANCELLED );
@@ -1344,25 +1369,25 @@ static int sock_close_handle( struct object *obj, struct process *process, obj_h
         if (sock->connect_req)
             async_terminate( sock->connect_req->async, STATUS_CANCELLED );
 
-        LIST_FOR_EACH_ENTRY_SAFE( poll_req, poll_next, &poll_list, struct poll_req, entry )
+restart:
+        LIST_FOR_EACH_ENTRY( entry, &sock->poll_list, struct poll_req_socket, entry )
         {
-            struct iosb *iosb = poll_req->iosb;
-            BOOL signaled = FALSE;
+            struct poll_req *poll_req = entry->req;
             unsigned int i;
 
-            if (iosb->status != STATUS_PENDING) continue;
+            if (poll_req->iosb->status != STATUS_PENDING) continue;
 
             for (i = 0; i < poll_req->count; ++i)
             {
                 if (poll_req->sockets[i].sock == sock)
                 {
-                    signaled = TRUE;
                     poll_req->output[i].flags = AFD_POLL_CLOSE;
                     poll_req->output[i].status = 0;
                 }
             }
 
-            if (signaled) complete_async_poll( poll_req, STATUS_SUCCESS );
+            complete_async_poll( poll_req, STATUS_SUCCESS );
+            goto restart;
         }
     }
 
@@ -1434,6 +1459,8 @@ static struct sock *create_socket(void)
     sock->sndbuf = 0;
     sock->rcvtimeo = 0;
     sock->sndtimeo = 0;
+    sock->read_batch = 1;
+    sock->read_time = 0;
     init_async_queue( &sock->read_q );
     init_async_queue( &sock->write_q );
     init_async_queue( &sock->ifchange_q );
@@ -1442,6 +1469,7 @@ static struct sock *create_socket(void)
     init_async_queue( &sock->poll_q );
     memset( sock->errors, 0, sizeof(sock->errors) );
     list_init( &sock->accept_list );
+    list_init( &sock->poll_list );
     return sock;
 }
 
@@ -2934,13 +2962,14 @@ static void poll_socket( struct sock *poll_sock, struct async *async, int exclus
         req->sockets[i].sock = (struct sock *)get_handle_obj( current->process, input[i].socket, 0, &sock_ops );
         if (!req->sockets[i].sock)
         {
-            for (j = 0; j < i; ++j) release_object( req->sockets[i].sock );
+            for (j = 0; j < i; ++j) release_object( req->sockets[j].sock );
             if (req->timeout) remove_timeout_user( req->timeout );
             free( req );
             free( output );
             return;
         }
         req->sockets[i].flags = input[i].flags;
+        req->sockets[i].req = req;
     }
 
     req->exclusive = exclusive;
@@ -2952,6 +2981,8 @@ static void poll_socket( struct sock *poll_sock, struct async *async, int exclus
     handle_exclusive_poll(req);
 
     list_add_tail( &poll_list, &req->entry );
+    for (i = 0; i < count; ++i)
+        list_add_tail( &req->sockets[i].sock->poll_list, &req->sockets[i].entry );
     async_set_completion_callback( async, free_poll_req, req );
     queue_async( &poll_sock->poll_q, async );
 